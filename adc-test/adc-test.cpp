@@ -18,95 +18,51 @@
  ******************************************************************************/
 
 #include "Arduino.h"
-#include "wiring_private.h"
+#include "AdcScan.h"
 
 #define ADC_PIN A2
 
-// found for my board using the SAMD_AnalogCorrection sketch
-#define ADC_OFFSET_CORRECTION 10
-#define ADC_GAIN_CORRECTION   2054
-//#define ADC_GAIN_CORRECTION   2050
+#define ASCALE (3.3 / 65536)
 
-#define ASCALE (3.3 / 4096)
-//#define ASCALE (3.3 / 65536)
-
-#define ADC_SYNC() do { } while (ADC->STATUS.bit.SYNCBUSY)
-#define ADC_GETR(_reg) (ADC->_reg.reg)
-#define ADC_SETR(_reg, _val) do { ADC->_reg.reg = (_val); ADC_SYNC(); } while(0)
-#define ADC_SETB(_reg, _val) do { ADC->_reg.reg |= (_val); ADC_SYNC(); } while(0)
-#define ADC_CLRB(_reg, _val) do { ADC->_reg.reg &= ~(_val); ADC_SYNC(); } while(0)
+// Scan A2 alone for 16-bit results at 10/s and print the mean of each second.
+// Each result is 16 hardware results averaged in software, and start() fills
+// the time between those with 1024 conversions of 2us sampling each.
+#define RESOLUTION      16
+#define OUTPUT_RATE     10
+#define DECIMATION      16
+#define BLOCK_FRAMES    10
 
 #define DEBUG_PORT 0
 #define DEBUG_PIN  2
 #include "debug_macros.h"
 
-static void adc_init(void)
-{
-    // SystemInit() handles setting the ADC calibration values from NVM
-    // init() (startup.c) configures the ADC with
-    //   * appropriate GCLK settings
-    //   * 512X clock prescaler
-    //   * 10-bit resolution
-    //   * max sampling time (SAMPCTRL = 0x3f)
-    //   * internal GND as negative input
-    //   * 1 sample and no adjust (AVGCTRL)
-    //   * calls analogReference(AR_DEFAULT)
-    //     - INTVCC1 (1/2 VDDANA = 1.65V), GAIN=DIV2
-
-    // disable ADC
-    ADC_CLRB(CTRLA, ADC_CTRLA_ENABLE);
-
-    // don't reset to avoid clearing the calibration registers
-    //ADC_SETR(CTRLA, ADC_CTRLA_SWRST);
-    //while (ADC->CTRLA.bit.SWRST);
-
-    // set 512x prescaler, 12-bit precision
-    ADC_SETR(CTRLB, ADC_CTRLB_PRESCALER_DIV512 | ADC_CTRLB_RESSEL_12BIT);
-#if defined(ADC_OFFSET_CORRECTION) && defined(ADC_GAIN_CORRECTION)
-    ADC->OFFSETCORR.reg = ADC_OFFSETCORR_OFFSETCORR(ADC_OFFSET_CORRECTION);
-    ADC->GAINCORR.reg = ADC_GAINCORR_GAINCORR(ADC_GAIN_CORRECTION);
-    ADC_SETB(CTRLB, ADC_CTRLB_CORREN);
-#endif
-
-    // maximum sampling time (more accurate but slower)
-    ADC_SETR(SAMPCTRL, 0x3f);
-
-    // set mux position and gain - pin input and internal ground
-    ADC_SETR(INPUTCTRL, ADC_INPUTCTRL_MUXPOS(g_APinDescription[ADC_PIN].ulADCChannelNumber) |
-                        ADC_INPUTCTRL_MUXNEG_GND |
-                        ADC_INPUTCTRL_GAIN_DIV2);
+static const uint8_t scan_pins[] = { ADC_PIN };
+static uint16_t samples[2 * BLOCK_FRAMES * DECIMATION];
+static AdcScan scan(TC4);
 
-    // set internal 1/2 VDDANA reference (3.3/2 = 1.65v)
-    ADC_SETR(REFCTRL, ADC_REFCTRL_REFSEL_INTVCC1);
+static volatile uint32_t block_sum;
+static volatile bool block_ready;
 
-    // average control
-    ADC_SETR(AVGCTRL, ADC_AVGCTRL_SAMPLENUM_8 |
-                      ADC_AVGCTRL_ADJRES(0x3));
-
-    // enable ADC
-    ADC_SETB(CTRLA, ADC_CTRLA_ENABLE);
-
-    // perform and discard one conversion
-    ADC_SETB(SWTRIG, ADC_SWTRIG_START);
-    while (ADC->INTFLAG.bit.RESRDY == 0);
-    ADC->INTFLAG.reg = ADC_INTFLAG_RESRDY;
-    ADC_SYNC();
-}
-
-static uint32_t adc_read(void)
+static void block_done(const uint16_t *block, uint32_t frames, void *ctx)
 {
-    ADC_SETB(SWTRIG, ADC_SWTRIG_START);
+    (void)ctx;
     DBGHIGH();
-    while (!ADC->INTFLAG.bit.RESRDY);
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < frames; i++)
+        sum += block[i];
+    block_sum = sum;
+    block_ready = true;
     DBGLOW();
-    return ADC_GETR(RESULT);
 }
 
 void setup(void)
 {
     DBGINIT();
-    pinPeripheral(ADC_PIN, PIO_ANALOG);
-    adc_init();
+    // init() already applied the correction saved by the adc-correction
+    // sketch, if any, and AdcScan keeps it enabled
+    if (!scan.begin(scan_pins, 1, RESOLUTION) ||
+            !scan.start(OUTPUT_RATE, samples, BLOCK_FRAMES, block_done, NULL, DECIMATION))
+        while (1);
 
     Serial1.begin(115200);
     Serial1.print("SAMD21 ADC\r\n");
@@ -118,7 +74,11 @@ void setup(void)
 
 void loop(void)
 {
-    uint32_t value = adc_read();
+    if (!block_ready)
+        return;
+    block_ready = false;
+
+    uint32_t value = (block_sum + BLOCK_FRAMES / 2) / BLOCK_FRAMES;
     double scaled = value * ASCALE;
 
     Serial1.printf("%04lx = ", value);
@@ -129,6 +89,4 @@ void loop(void)
     SerialUSB.print(scaled, 3);
     SerialUSB.print("\n");
     //SerialUSB.printf("%04lx = %f\n", value, scaled);
-
-    delay(1000);
 }
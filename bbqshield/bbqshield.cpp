@@ -25,6 +25,7 @@
 
 #include "Arduino.h"
 #include "DigitalIO.h"
+#include "InputEvents.h"
 #include "wiring_private.h"
 #include "Neostrip.h"
 #include "Timer.h"
@@ -80,53 +81,70 @@ Timer heartbeat_timer(TC5, timer_isr);
 DECLARE_TIMER_HANDLER(TC5, heartbeat_timer)
 
 #if AUTO_BRIGHTNESS
-// one button to enable/disable
-static volatile bool disabled = false;
-static volatile bool switch_animations = false;
-static void pb_onoff_isr(void)  { disabled = !disabled; }
-static void pb_switch_isr(void) { switch_animations = true; }
-DigitalIn pb_onoff(8, INPUT_PULLUP);
-DigitalIn pb_switch(9, INPUT_PULLUP);
-#else
-// brightness control variables
-static volatile int brightness = DEF_BRIGHTNESS;
-static volatile bool brightness_update = true;
-DigitalIn pb_bright_up(8, INPUT_PULLUP);
-DigitalIn pb_bright_down(9, INPUT_PULLUP);
-
-// brightness control ISRs
-static void brightness_up(void)   { brightness += BRIGHTNESS_STEP; brightness_update = true; }
-static void brightness_down(void) { brightness -= BRIGHTNESS_STEP; brightness_update = true; }
-static inline uint8_t clamp_brightness(void)
+// one button to enable/disable, one to switch animations
+enum { PB_ONOFF, PB_SWITCH };
+InputButton pb_onoff(PB_ONOFF, 8);
+InputButton pb_switch(PB_SWITCH, 9);
+static bool disabled = false;
+static bool switch_animations = false;
+
+static void handle_inputs(void)
 {
-    __disable_irq();
-    int b = brightness;
-    if (b < 0)
+    InputEvent ev;
+    while (input_event_pop(&ev))
     {
-        b = brightness = 0;
+        if (ev.type != INPUT_PRESS)
+            continue;
+        if (ev.id == PB_ONOFF)
+            disabled = !disabled;
+        else if (ev.id == PB_SWITCH)
+            switch_animations = true;
     }
-    else if (b > 255)
+}
+#else
+// brightness control buttons and variables
+enum { PB_BRIGHT_UP, PB_BRIGHT_DOWN };
+InputButton pb_bright_up(PB_BRIGHT_UP, 8);
+InputButton pb_bright_down(PB_BRIGHT_DOWN, 9);
+static int brightness = DEF_BRIGHTNESS;
+static bool brightness_update = true;
+
+static void handle_inputs(void)
+{
+    InputEvent ev;
+    while (input_event_pop(&ev))
     {
-        b = brightness = 255;
+        if (ev.type != INPUT_PRESS)
+            continue;
+        brightness += (ev.id == PB_BRIGHT_UP) ? BRIGHTNESS_STEP : -BRIGHTNESS_STEP;
+        brightness_update = true;
     }
+}
+
+static inline uint8_t clamp_brightness(void)
+{
+    if (brightness < 0)
+        brightness = 0;
+    else if (brightness > 255)
+        brightness = 255;
     brightness_update = false;
-    __enable_irq();
-    return (uint8_t)b;
+    return (uint8_t)brightness;
 }
 #endif // AUTO_BRIGHTNESS
 
 void setup(void)
 {
-    // init debug pin, RNG, and brightness button IRQs
+    // init debug pin, RNG, and debounced buttons
     DBGINIT();
     DBGHIGH();
     SRAND(RANDOM_SEED);
+    timer_service_init();
 #if AUTO_BRIGHTNESS
-    pb_onoff.add_interrupt(pb_onoff_isr, FALLING);
-    pb_switch.add_interrupt(pb_switch_isr, FALLING);
+    pb_onoff.begin();
+    pb_switch.begin();
 #else
-    pb_bright_up.add_interrupt(brightness_up, FALLING);
-    pb_bright_down.add_interrupt(brightness_down, FALLING);
+    pb_bright_up.begin();
+    pb_bright_down.begin();
 #endif
 
     // init the SPI and move pin 13 back to GPIO for debug rather than SCLK
@@ -146,7 +164,7 @@ void setup(void)
 
     // set up the heartbeat timer, flashes every main cycle through loop()
     heartbeat_timer.init();
-    heartbeat_timer.set_us(20000);
+    heartbeat_timer.set_us<20000>();
 
     ga1.reset();
     ga2.reset();
@@ -159,6 +177,8 @@ void setup(void)
 
 void loop(void)
 {
+    handle_inputs();
+
 #if AUTO_BRIGHTNESS
     static constexpr uint8_t bmin = 40;
     static constexpr uint8_t bmax = 125;
@@ -175,7 +195,10 @@ void loop(void)
         ns1.write();
         // sleep until enable button toggles again
         while (disabled)
+        {
             __WFI();
+            handle_inputs();
+        }
     }
 
     if (bstep == bsteps)
@@ -199,8 +222,9 @@ void loop(void)
 #else
     if (brightness_update)
     {
-        ns.set_brightness(clamp_brightness());
-        ns1.set_brightness(clamp_brightness());
+        const uint8_t b = clamp_brightness();
+        ns.set_brightness(b);
+        ns1.set_brightness(b);
     }
 #endif
     // write current frame
@@ -0,0 +1,137 @@
+/*******************************************************************************
+ * Microbenchmark framework, for the SAMD21 and natively on a PC
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#ifdef __thumb__
+#include "Arduino.h"
+#else
+#include <time.h>
+#endif
+#include "Bench.h"
+
+#ifdef __thumb__
+const char bench_unit[] = "cycles";
+
+// The tick can't advance with interrupts disabled, but SysTick may have
+// wrapped and be waiting to run. If so, count that tick and re-read VAL in
+// case the wrap happened after the first read.
+uint32_t bench_now(void)
+{
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    uint32_t ms = millis();
+    uint32_t val = SysTick->VAL;
+    if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk)
+    {
+        ms++;
+        val = SysTick->VAL;
+    }
+    const uint32_t reload = SysTick->LOAD;
+
+    __set_PRIMASK(primask);
+    return ms * (reload + 1) + (reload - val);
+}
+#else
+const char bench_unit[] = "ns";
+
+uint32_t bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)ts.tv_sec * 1000000000u + (uint32_t)ts.tv_nsec;
+}
+#endif
+
+static void empty_func(void *ctx)
+{
+    (void)ctx;
+}
+
+// noinline so that every benchmark and the calibration run the same loop code
+static __attribute__((noinline)) uint32_t time_loop(BenchFunc func, void *ctx, uint32_t iters)
+{
+    const uint32_t start = bench_now();
+    for (uint32_t i = 0; i < iters; i++)
+        func(ctx);
+    return bench_now() - start;
+}
+
+static void sort(uint32_t *vals, size_t count)
+{
+    for (size_t i = 1; i < count; i++)
+    {
+        const uint32_t v = vals[i];
+        size_t j = i;
+        for (; j > 0 && vals[j-1] > v; j--)
+            vals[j] = vals[j-1];
+        vals[j] = v;
+    }
+}
+
+BenchResult bench_run(const BenchCase &bc)
+{
+    // call through a volatile pointer so the empty function can't be inlined
+    BenchFunc volatile empty = empty_func;
+    uint32_t overhead = UINT32_MAX;
+    for (int i = 0; i < BENCH_SAMPLES; i++)
+    {
+        const uint32_t t = time_loop(empty, NULL, bc.iters);
+        if (t < overhead)
+            overhead = t;
+    }
+
+    uint32_t samples[BENCH_SAMPLES];
+    for (int i = 0; i < BENCH_SAMPLES; i++)
+    {
+        if (bc.setup != NULL)
+            bc.setup(bc.ctx);
+        const uint32_t t = time_loop(bc.func, bc.ctx, bc.iters);
+        samples[i] = (t > overhead ? t - overhead : 0) / bc.iters;
+    }
+    sort(samples, BENCH_SAMPLES);
+
+    BenchResult r;
+    r.min = samples[0];
+    r.median = samples[BENCH_SAMPLES / 2];
+    r.max = samples[BENCH_SAMPLES - 1];
+    r.overhead = overhead / bc.iters;
+    return r;
+}
+
+void bench_print_start(Print &out)
+{
+    out.printf("# bench start samples=%d\r\n"_fmt, BENCH_SAMPLES);
+}
+
+void bench_print_end(Print &out)
+{
+    out.print("# bench end\r\n");
+}
+
+void bench_run_all(Print &out, const BenchCase *cases, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        const BenchCase &bc = cases[i];
+        const BenchResult r = bench_run(bc);
+        out.printf("BENCH name=%s iters=%u min=%u median=%u max=%u overhead=%u unit=%s\r\n"_fmt,
+                   bc.name, (unsigned)bc.iters, (unsigned)r.min, (unsigned)r.median,
+                   (unsigned)r.max, (unsigned)r.overhead, bench_unit);
+    }
+}
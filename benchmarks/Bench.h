@@ -0,0 +1,90 @@
+/*******************************************************************************
+ * Microbenchmark framework, for the SAMD21 and natively on a PC
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+/*
+ * Each benchmark calls func(ctx) iters times in a loop, and the loop is timed
+ * BENCH_SAMPLES times. The time of the same loop calling an empty function is
+ * subtracted, so the results are the cost of the function body alone. setup,
+ * if not NULL, runs untimed before each sample.
+ *
+ * On the SAMD21, time is counted in CPU cycles from SysTick. SysTick is only
+ * 24 bits and reloads every millisecond, so the millis() tick is combined with
+ * the count (see bench_now()), and a sample can take up to 89 seconds.
+ * On a PC, time is in nanoseconds from CLOCK_MONOTONIC.
+ *
+ * Results are printed one per line:
+ *   BENCH name=<name> iters=<n> min=<t> median=<t> max=<t> overhead=<t> unit=<cycles|ns>
+ * with times per call, between "# bench start" and "# bench end" lines.
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Print.h"
+
+// number of timed samples of each benchmark, odd so there's a middle one
+#ifndef BENCH_SAMPLES
+#define BENCH_SAMPLES 15
+#endif
+
+typedef void (*BenchFunc)(void *ctx);
+
+struct BenchCase {
+    const char *name;
+    BenchFunc func;
+    void *ctx;
+    uint32_t iters;
+    BenchFunc setup;
+};
+
+struct BenchResult {
+    uint32_t min;
+    uint32_t median;
+    uint32_t max;
+    uint32_t overhead;  // empty loop time per call, already subtracted
+};
+
+// the timestamp unit, "cycles" or "ns"
+extern const char bench_unit[];
+
+uint32_t bench_now(void);
+
+BenchResult bench_run(const BenchCase &bc);
+
+// Run each benchmark and print its results
+void bench_run_all(Print &out, const BenchCase *cases, size_t count);
+
+// start and end markers around bench_run_all output
+void bench_print_start(Print &out);
+void bench_print_end(Print &out);
+
+// Keep the compiler from optimizing away a computed value
+template<typename T>
+static inline void bench_keep(const T &val)
+{
+    asm volatile("" : : "g"(&val) : "memory");
+}
+
+// benchmarks of portable code, from bench_cases.cpp
+extern const BenchCase bench_portable_cases[];
+extern const size_t bench_portable_count;
+
+#endif // BENCH_H
@@ -0,0 +1,128 @@
+/*******************************************************************************
+ * Benchmarks of portable code, built for the SAMD21 and the host
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include <string.h>
+#include "Bench.h"
+#include "Print.h"
+#include "RingBuffer.h"
+#include "TimerQueue.h"
+#include "fmtnum.h"
+
+// Print which counts and discards everything
+class NullPrint : public Print
+{
+    public:
+        size_t count = 0;
+        size_t write(uint8_t) override { count++; return 1; }
+        size_t write(const uint8_t *, size_t size) override { count += size; return size; }
+};
+static NullPrint null_print;
+
+// Values come from volatiles so the compiler can't fold the formatting
+static volatile uint32_t bench_u32 = 4000000000u;
+static volatile int32_t bench_i32 = -12345;
+static volatile float bench_float = 3.14159f;
+
+static void bench_fmt_u32_dec(void *ctx)
+{
+    (void)ctx;
+    char buf[FMT_U32_MAX_LEN];
+    bench_keep(fmt_u32_dec(buf + sizeof(buf), bench_u32));
+}
+
+static void bench_fmt_u32_hex(void *ctx)
+{
+    (void)ctx;
+    char buf[FMT_U32_MAX_LEN];
+    bench_keep(fmt_u32_hex(buf + sizeof(buf), bench_u32, false));
+}
+
+static void bench_fmt_double(void *ctx)
+{
+    (void)ctx;
+    char buf[FMT_DOUBLE_MAX_LEN];
+    bench_keep(fmt_double(buf, bench_float, 2));
+}
+
+static void bench_print_u32(void *ctx)
+{
+    (void)ctx;
+    null_print.print((unsigned long)bench_u32);
+}
+
+static void bench_printf_fmt(void *ctx)
+{
+    (void)ctx;
+    null_print.printf("count=%u value=%-6d temp=%.2f\r\n"_fmt,
+                      (unsigned)bench_u32, (int)bench_i32, (double)bench_float);
+}
+
+static void bench_printf_vararg(void *ctx)
+{
+    (void)ctx;
+    null_print.printf("count=%u value=%-6d\r\n", (unsigned)bench_u32, (int)bench_i32);
+}
+
+// fill and drain 64 bytes
+static RingBuffer ring;
+static void bench_ringbuffer(void *ctx)
+{
+    (void)ctx;
+    for (int i = 0; i < 64; i++)
+        ring.store_char((uint8_t)i);
+    while (ring.available())
+        bench_keep(ring.read_char());
+}
+
+static void bench_ringbuffer_read_chars(void *ctx)
+{
+    (void)ctx;
+    uint8_t buf[64];
+    for (int i = 0; i < 64; i++)
+        ring.store_char((uint8_t)i);
+    bench_keep(ring.read_chars(buf, sizeof(buf)));
+}
+
+// schedule 16 timers with scattered deadlines, then pop them all
+static void timer_nop(void *) { }
+static TimerEvent timer_events[16] = {
+    timer_nop, timer_nop, timer_nop, timer_nop, timer_nop, timer_nop, timer_nop, timer_nop,
+    timer_nop, timer_nop, timer_nop, timer_nop, timer_nop, timer_nop, timer_nop, timer_nop,
+};
+static TimerQueue timer_queue;
+static void bench_timerqueue(void *ctx)
+{
+    (void)ctx;
+    for (unsigned int i = 0; i < 16; i++)
+        timer_queue.schedule(timer_events[i], (i * 7919u) & 0xfff);
+    while (timer_queue.pop_expired(0x1000) != NULL);
+}
+
+const BenchCase bench_portable_cases[] = {
+    { "fmt_u32_dec",            bench_fmt_u32_dec,          NULL, 100, NULL },
+    { "fmt_u32_hex",            bench_fmt_u32_hex,          NULL, 100, NULL },
+    { "fmt_double",             bench_fmt_double,           NULL, 100, NULL },
+    { "print_u32",              bench_print_u32,            NULL, 100, NULL },
+    { "printf_fmt",             bench_printf_fmt,           NULL, 20,  NULL },
+    { "printf_vararg",          bench_printf_vararg,        NULL, 20,  NULL },
+    { "ringbuffer_64",          bench_ringbuffer,           NULL, 10,  NULL },
+    { "ringbuffer_read_chars",  bench_ringbuffer_read_chars, NULL, 10, NULL },
+    { "timerqueue_16",          bench_timerqueue,           NULL, 10,  NULL },
+};
+const size_t bench_portable_count = sizeof(bench_portable_cases) / sizeof(bench_portable_cases[0]);
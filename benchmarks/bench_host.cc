@@ -0,0 +1,51 @@
+/*******************************************************************************
+ * Host build of the portable benchmarks
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+/*
+ * bench_host.cc: runs the benchmarks in bench_cases.cpp natively, with the
+ * same output format as the firmware. Extension is .cc instead of .cpp so that
+ * the samd21 Makefile ignores it.
+ *
+ * Build and run:
+ *   make bench-host
+ */
+
+#include <stdio.h>
+#include "Bench.h"
+
+class StdoutPrint : public Print
+{
+    public:
+        size_t write(uint8_t c) override
+        {
+            // drop the \r from \r\n line endings
+            if (c != '\r')
+                putchar(c);
+            return 1;
+        }
+};
+
+int main(void)
+{
+    StdoutPrint out;
+    bench_print_start(out);
+    bench_run_all(out, bench_portable_cases, bench_portable_count);
+    bench_print_end(out);
+    return 0;
+}
@@ -0,0 +1,191 @@
+/*******************************************************************************
+ * Microbenchmarks, results printed over SerialUSB
+ *
+ * Copyright (C) 2018 Allen Wild <allenwild93@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+/*
+ * Send any character over SerialUSB to run every benchmark. Results are
+ * machine readable, see Bench.h. The portable benchmarks in bench_cases.cpp
+ * also build and run on a PC with "make bench-host".
+ *
+ * Build with -DBENCH_EIC_LOOPBACK and connect pin 4 to pin 2 to also measure
+ * the latency from an input edge to its attachInterrupt() callback.
+ */
+
+#include "Arduino.h"
+#include "DigitalIO.h"
+#include "FastIO.h"
+#include "Neostrip.h"
+#include "SPI.h"
+#include "wiring_digital.h"
+#include "Bench.h"
+
+#define STRIP_LENGTH 8
+#define SPI_BUF_LEN 16
+
+static Neostrip<STRIP_LENGTH> ns(SPI);
+static DigitalOut digital_out(PIN_LED_TXL);
+static FastOut<PIN_LED_TXL> fast_out;
+static uint8_t spi_buf[SPI_BUF_LEN];
+
+static void bench_micros(void *ctx)
+{
+    (void)ctx;
+    bench_keep(micros());
+}
+
+static void bench_digital_write(void *ctx)
+{
+    (void)ctx;
+    digitalWrite(PIN_LED_TXL, HIGH);
+    digitalWrite(PIN_LED_TXL, LOW);
+}
+
+static void bench_digital_write_fast(void *ctx)
+{
+    (void)ctx;
+    digitalWriteFast(PIN_LED_TXL, HIGH);
+    digitalWriteFast(PIN_LED_TXL, LOW);
+}
+
+static void bench_digitalout_write(void *ctx)
+{
+    (void)ctx;
+    digital_out = 1;
+    digital_out = 0;
+}
+
+static void bench_fastout_write(void *ctx)
+{
+    (void)ctx;
+    fast_out = 1;
+    fast_out = 0;
+}
+
+// One conversion each with the default DIV512 prescaler and maximum sampling
+// time, so these mostly show how many conversions analogRead() does
+static void bench_analog_read(void *ctx)
+{
+    (void)ctx;
+    bench_keep(analogRead(A1));
+}
+
+static void bench_analog_read_alt(void *ctx)
+{
+    (void)ctx;
+    bench_keep(analogRead(A1));
+    bench_keep(analogRead(A2));
+}
+
+#ifdef BENCH_EIC_LOOPBACK
+#define EIC_OUT_PIN 4
+#define EIC_IN_PIN  2
+
+static FastOut<EIC_OUT_PIN> eic_out;
+static volatile uint32_t eic_count;
+
+static void eic_isr(void)
+{
+    eic_count++;
+}
+
+static void eic_nop_isr(void) {}
+
+// Toggle the output and wait for the callback, so the time is the edge to
+// callback latency plus a few cycles of loop
+static void bench_eic_latency(void *ctx)
+{
+    (void)ctx;
+    const uint32_t count = eic_count;
+    eic_out.toggle();
+    while (eic_count == count);
+}
+
+static void eic_loopback_init(void)
+{
+    // Attach other lines first, which are never triggered but would be
+    // walked past by a dispatcher that searches in attach order
+    static const uint8_t other_pins[] = { 3, 5, 6, 7 };
+    for (uint8_t pin : other_pins)
+    {
+        pinMode(pin, INPUT_PULLUP);
+        attachInterrupt(pin, eic_nop_isr, FALLING);
+    }
+
+    pinMode(EIC_IN_PIN, INPUT);
+    attachInterrupt(EIC_IN_PIN, eic_isr, CHANGE);
+}
+#endif
+
+static void bench_spi_transfer(void *ctx)
+{
+    (void)ctx;
+    SPI.transfer(spi_buf, sizeof(spi_buf));
+}
+
+// Color expansion and starting the DMA, the transfer itself is waited for
+// (untimed) in setup
+static void bench_neostrip_write(void *ctx)
+{
+    (void)ctx;
+    ns.write(false);
+}
+
+static void wait_neostrip(void *ctx)
+{
+    (void)ctx;
+    ns.wait_for_complete();
+}
+
+static const BenchCase hw_cases[] = {
+    { "micros",                bench_micros,              NULL, 100, NULL },
+    { "digital_write_x2",      bench_digital_write,       NULL, 100, NULL },
+    { "digital_write_fast_x2", bench_digital_write_fast,  NULL, 100, NULL },
+    { "digitalout_write_x2",   bench_digitalout_write,    NULL, 100, NULL },
+    { "fastout_write_x2",      bench_fastout_write,       NULL, 100, NULL },
+    { "analog_read",           bench_analog_read,         NULL, 10,  NULL },
+    { "analog_read_alt_x2",    bench_analog_read_alt,     NULL, 10,  NULL },
+#ifdef BENCH_EIC_LOOPBACK
+    { "eic_latency",           bench_eic_latency,         NULL, 100, NULL },
+#endif
+    { "spi_transfer_16",       bench_spi_transfer,        NULL, 10,  NULL },
+    { "neostrip_write_8",      bench_neostrip_write,      NULL, 1,   wait_neostrip },
+};
+
+void setup(void)
+{
+    // Neostrip sets up SPI with its own clock, it's only used as a data sink
+    // here so the other SPI benchmark shares it
+    ns.init();
+    for (unsigned int i = 0; i < STRIP_LENGTH; i++)
+        ns.set_color(i, 0x102030u * i);
+
+#ifdef BENCH_EIC_LOOPBACK
+    eic_loopback_init();
+#endif
+}
+
+void loop(void)
+{
+    if (SerialUSB.read() < 0)
+        return;
+
+    bench_print_start(SerialUSB);
+    bench_run_all(SerialUSB, bench_portable_cases, bench_portable_count);
+    bench_run_all(SerialUSB, hw_cases, sizeof(hw_cases) / sizeof(hw_cases[0]));
+    bench_print_end(SerialUSB);
+}
@@ -327,7 +327,9 @@ static void sam_ba_monitor_loop(void)
 
 				uint32_t dst_addr = current_number; // starting address
 
-				while (dst_addr < MAX_FLASH) {
+				// The last row holds the application's ADC calibration
+				// (adc_calibration.h) and is kept across uploads.
+				while (dst_addr < MAX_FLASH - PAGE_SIZE * 4) {
 					// Execute "ER" Erase Row
 					NVMCTRL->ADDR.reg = dst_addr / 2;
 					NVMCTRL->CTRLA.reg = NVMCTRL_CTRLA_CMDEX_KEY | NVMCTRL_CTRLA_CMD_ER;
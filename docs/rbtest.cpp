@@ -45,5 +45,16 @@ int main()
   printf("after resize head=%d, tail=%d available=%d\n", rb._iHead, rb._iTail, rb.available());
   print_rb(rb);
 
+  // bulk read across the wrap point
+  RingBuffer small(16);
+  write_to_rb(small, "0123456789");
+  print_rb(small, 10);
+  putchar('\n');
+  write_to_rb(small, "wrapped line\n");
+  char buf[32] = {0};
+  size_t n = small.read_chars((uint8_t*)buf, 5);
+  n += small.read_chars((uint8_t*)buf + n, sizeof(buf) - 1 - n);
+  printf("read_chars got %zu: %s", n, buf);
+
   return 0;
 }
@@ -63,7 +63,7 @@ void loop()
     if (keypad_event)
     {
         uint16_t data = keypad.readTouchData();
-        SerialUSB.printf("%04x\n", data);
+        SerialUSB.printf("%04x\n"_fmt, data);
         blue_led = keypad_event = false;
     }
 }
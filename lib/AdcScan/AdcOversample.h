@@ -0,0 +1,170 @@
+/*******************************************************************************
+ * ADC clock, sampling time and hardware averaging settings for a target rate
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+/*
+ * With AVGCTRL the ADC accumulates 2^SAMPLENUM conversions per result. Every
+ * 4x more samples adds one bit, so 13-16 bit results need 4, 16, 64 and 256
+ * samples. Above 16 samples the accumulator is shifted right automatically to
+ * fit 16 bits (by SAMPLENUM - 4), and ADJRES shifts the rest of the way:
+ *
+ *   bits  samples  auto shift  ADJRES
+ *    12      1         0         0
+ *    13      4         0         1
+ *    14     16         0         2
+ *    15     64         2         1
+ *    16    256         4         0
+ *
+ * Any time left over at the requested rate, less a safety margin, goes to more
+ * samples, up to 1024, which lowers the noise without adding bits, and then to
+ * a longer sampling time. Plain C with no register access, so it also builds
+ * on a PC for adc_oversample_test.cc.
+ */
+
+#ifndef ADCOVERSAMPLE_H
+#define ADCOVERSAMPLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// datasheet maximum ADC clock
+#define ADC_OVERSAMPLE_MAX_CLK_HZ   2100000ul
+#define ADC_OVERSAMPLE_MAX_SAMPLEN  63
+#define ADC_OVERSAMPLE_MAX_LOG2N    10
+
+// pass as samplen to have it chosen
+#define ADC_OVERSAMPLE_SAMPLEN_AUTO 0xff
+
+// Time per result held back from the conversions, as a shift of the total
+// and in half ADC clocks. The trigger timer runs from the DFLL but the ADC
+// from a +/-2% RC oscillator, and each START event waits to synchronize to
+// the ADC clock. A conversion that overruns the next START drops it, so
+// without this the rate could silently come out low.
+#define ADC_OVERSAMPLE_MARGIN_SHIFT         4
+#define ADC_OVERSAMPLE_SYNC_HALF_CLOCKS     2
+
+typedef struct {
+    uint8_t prescaler;  // CTRLB.PRESCALER, the ADC clock is gclk / (4 << prescaler)
+    uint8_t samplen;    // SAMPCTRL.SAMPLEN
+    uint8_t samplenum;  // AVGCTRL.SAMPLENUM, log2 of the samples per result
+    uint8_t adjres;     // AVGCTRL.ADJRES
+} AdcOversamplePlan;
+
+static inline bool adc_oversample_bits_valid(unsigned int bits)
+{
+    return bits == 8 || bits == 10 || (bits >= 12 && bits <= 16);
+}
+
+static inline uint32_t adc_oversample_clk_hz(uint32_t gclk_hz, unsigned int prescaler)
+{
+    return gclk_hz / (4ul << prescaler);
+}
+
+// fastest prescaler that keeps the ADC clock in spec
+static inline unsigned int adc_oversample_prescaler(uint32_t gclk_hz)
+{
+    unsigned int prescaler = 0;
+    while (prescaler < 7 && adc_oversample_clk_hz(gclk_hz, prescaler) > ADC_OVERSAMPLE_MAX_CLK_HZ)
+        prescaler++;
+    return prescaler;
+}
+
+// One conversion in half ADC clocks: sampling is (samplen + 1) / 2 clocks,
+// then 1 + bits / 2. Oversampled results convert at 12 bits.
+static inline uint32_t adc_oversample_half_clocks(unsigned int samplen, unsigned int bits)
+{
+    return samplen + 1 + 2 + (bits < 12 ? bits : 12);
+}
+
+static inline unsigned int adc_oversample_min_log2n(unsigned int bits)
+{
+    return bits > 12 ? 2 * (bits - 12) : 0;
+}
+
+// Half ADC clocks per result that conversions may use, after the margin
+static inline uint32_t adc_oversample_budget(uint32_t adc_hz, uint32_t rate)
+{
+    const uint32_t period = 2 * adc_hz / rate;
+    const uint32_t margin = (period >> ADC_OVERSAMPLE_MARGIN_SHIFT) + ADC_OVERSAMPLE_SYNC_HALF_CLOCKS;
+    return period > margin ? period - margin : 0;
+}
+
+// Fastest result rate for the resolution. A fixed samplen is used as is, AUTO
+// counts as the minimum.
+static inline uint32_t adc_oversample_max_rate(uint32_t gclk_hz, unsigned int bits, unsigned int samplen)
+{
+    const uint32_t adc_hz = adc_oversample_clk_hz(gclk_hz, adc_oversample_prescaler(gclk_hz));
+    if (samplen == ADC_OVERSAMPLE_SAMPLEN_AUTO)
+        samplen = 0;
+    const uint32_t cost = adc_oversample_half_clocks(samplen, bits) << adc_oversample_min_log2n(bits);
+
+    // estimate from the margin, then settle on the exact edge of the budget
+    uint32_t rate = 2 * adc_hz / (cost + ADC_OVERSAMPLE_SYNC_HALF_CLOCKS);
+    rate -= rate >> ADC_OVERSAMPLE_MARGIN_SHIFT;
+    while (rate > 1 && adc_oversample_budget(adc_hz, rate) < cost)
+        rate--;
+    while (adc_oversample_budget(adc_hz, rate + 1) >= cost)
+        rate++;
+    return rate;
+}
+
+/*
+ * Settings for results of the given resolution (8, 10, or 12-16 bits) at rate
+ * results per second. With a fixed samplen only the minimum number of samples
+ * is used. Returns false if the rate can't be reached.
+ */
+static inline bool adc_oversample_plan(uint32_t gclk_hz, uint32_t rate, unsigned int bits,
+                                       unsigned int samplen, AdcOversamplePlan *plan)
+{
+    if (rate == 0 || !adc_oversample_bits_valid(bits) ||
+            (samplen > ADC_OVERSAMPLE_MAX_SAMPLEN && samplen != ADC_OVERSAMPLE_SAMPLEN_AUTO))
+        return false;
+
+    const unsigned int prescaler = adc_oversample_prescaler(gclk_hz);
+    const uint32_t budget = adc_oversample_budget(adc_oversample_clk_hz(gclk_hz, prescaler), rate);
+    const bool auto_samplen = (samplen == ADC_OVERSAMPLE_SAMPLEN_AUTO);
+    const uint32_t min_half_clocks = adc_oversample_half_clocks(auto_samplen ? 0 : samplen, bits);
+
+    unsigned int log2n = adc_oversample_min_log2n(bits);
+    if ((min_half_clocks << log2n) > budget)
+        return false;
+
+    if (auto_samplen)
+    {
+        // 8 and 10 bit results can't be averaged
+        const unsigned int max_log2n = bits < 12 ? 0 : ADC_OVERSAMPLE_MAX_LOG2N;
+        while (log2n < max_log2n && (min_half_clocks << (log2n + 1)) <= budget)
+            log2n++;
+
+        samplen = (budget >> log2n) - adc_oversample_half_clocks(0, bits);
+        if (samplen > ADC_OVERSAMPLE_MAX_SAMPLEN)
+            samplen = ADC_OVERSAMPLE_MAX_SAMPLEN;
+    }
+
+    // the sum has 12 + log2n bits, keep bits of them
+    const unsigned int shift = log2n - adc_oversample_min_log2n(bits) / 2;
+    const unsigned int auto_shift = log2n > 4 ? log2n - 4 : 0;
+
+    plan->prescaler = prescaler;
+    plan->samplen = samplen;
+    plan->samplenum = log2n;
+    plan->adjres = shift - auto_shift;
+    return true;
+}
+
+#endif // ADCOVERSAMPLE_H
@@ -0,0 +1,293 @@
+/*******************************************************************************
+ * Timer-triggered multichannel ADC scan with DMA double buffering
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include "Arduino.h"
+#include "wiring_private.h"
+#include "AdcScan.h"
+#include "EventRoute.h"
+#include "tc_prescaler.h"
+
+// GCLK3 is OSC8M, the planner picks DIV4 for 2MHz, under the 2.1MHz maximum
+#define ADCSCAN_GCLK_HZ     8000000ul
+
+// highest AIN on the SAMD21G
+#define ADCSCAN_MAX_AIN     19
+
+static inline void adc_sync(void)
+{
+    while (ADC->STATUS.bit.SYNCBUSY);
+}
+
+static inline void adc_set_gclk(uint32_t gen)
+{
+    GCLK->CLKCTRL.reg = (uint16_t)(GCLK_CLKCTRL_ID(GCM_ADC) | gen | GCLK_CLKCTRL_CLKEN);
+    while (GCLK->STATUS.bit.SYNCBUSY);
+}
+
+bool AdcScan::begin(const uint8_t *pins, unsigned int count, unsigned int resolution,
+                    unsigned int samplen)
+{
+    if (_running || count == 0 || !adc_oversample_bits_valid(resolution) ||
+            (samplen > ADC_SAMPCTRL_SAMPLEN_Msk && samplen != ADC_OVERSAMPLE_SAMPLEN_AUTO))
+        return false;
+
+    uint32_t lo = ADCSCAN_MAX_AIN, hi = 0;
+    for (unsigned int i = 0; i < count; i++)
+    {
+        if (pins[i] >= PINS_COUNT)
+            return false;
+        const uint32_t ain = g_APinDescription[pins[i]].ulADCChannelNumber;
+        if (ain > ADCSCAN_MAX_AIN)
+            return false;
+        if (ain < lo) lo = ain;
+        if (ain > hi) hi = ain;
+    }
+
+    for (unsigned int i = 0; i < count; i++)
+    {
+        // AIN0 is shared with the DAC output, same as analogRead()
+        if (g_APinDescription[pins[i]].ulADCChannelNumber == ADC_Channel0)
+        {
+            DAC->CTRLA.bit.ENABLE = 0;
+            while (DAC->STATUS.bit.SYNCBUSY);
+        }
+        pinPeripheral(pins[i], PIO_ANALOG);
+    }
+
+    _first_ain = lo;
+    _frame_size = hi - lo + 1;
+    _resolution = resolution;
+    _samplen = samplen;
+    return true;
+}
+
+int AdcScan::index(uint32_t pin) const
+{
+    if (pin >= PINS_COUNT)
+        return -1;
+    const uint32_t ain = g_APinDescription[pin].ulADCChannelNumber;
+    if (ain < _first_ain || ain >= (uint32_t)_first_ain + _frame_size)
+        return -1;
+    return ain - _first_ain;
+}
+
+uint32_t AdcScan::max_rate(void) const
+{
+    return adc_oversample_max_rate(ADCSCAN_GCLK_HZ, _resolution, _samplen);
+}
+
+bool AdcScan::start(uint32_t frame_rate, uint16_t *buffer, uint32_t frames_per_block,
+                    AdcScanCallback callback, void *ctx, uint32_t decimation)
+{
+    if (_running || _frame_size == 0 || frame_rate == 0 || buffer == NULL ||
+            decimation == 0 || (decimation & (decimation - 1)) != 0)
+        return false;
+
+    const uint32_t rate = frame_rate * decimation * _frame_size;
+    const uint32_t block_len = frames_per_block * decimation * _frame_size;
+    AdcOversamplePlan plan;
+    if (!adc_oversample_plan(ADCSCAN_GCLK_HZ, rate, _resolution, _samplen, &plan) ||
+            block_len == 0 || block_len > 0xffff)
+        return false;
+
+    _buffer = buffer;
+    _block_len = block_len;
+    _decimation_shift = __builtin_ctz(decimation);
+    _callback = callback;
+    _ctx = ctx;
+    _blocks = 0;
+
+    // Two looping descriptors, one per block, each interrupting when done.
+    // ZeroDMA can't free descriptors, so later starts reuse them.
+    if (_desc[0] == NULL)
+    {
+        _dma.setTrigger(ADC_DMAC_ID_RESRDY);
+        _dma.setAction(DMA_TRIGGER_ACTON_BEAT);
+        if (_dma.allocate() != DMA_STATUS_OK)
+            return false;
+        _dma.loop(true);
+        for (int i = 0; i < 2; i++)
+        {
+            _desc[i] = _dma.addDescriptor((void*)&ADC->RESULT.reg, buffer + i * block_len,
+                                          block_len, DMA_BEAT_SIZE_HWORD, false, true);
+            _desc[i]->BTCTRL.bit.BLOCKACT = DMA_BLOCK_ACTION_INT;
+        }
+        _dma.setCallback(dma_callback, DMA_CALLBACK_TRANSFER_DONE, this);
+    }
+    else
+    {
+        for (int i = 0; i < 2; i++)
+            _dma.changeDescriptor(_desc[i], NULL, buffer + i * block_len, block_len);
+    }
+
+    _event_channel = event_route_connect(event_gen_tc_ovf(_tc), EVSYS_ID_USER_ADC_START,
+                                         EVENT_PATH_SYNC, EVENT_EDGE_RISING);
+    if (_event_channel < 0)
+        return false;
+
+    // take over the ADC
+    adc_sync();
+    _saved_ctrlb = ADC->CTRLB.reg;
+    _saved_sampctrl = ADC->SAMPCTRL.reg;
+    _saved_avgctrl = ADC->AVGCTRL.reg;
+    _saved_inputctrl = ADC->INPUTCTRL.reg;
+
+    ADC->CTRLA.bit.ENABLE = 0;
+    adc_sync();
+    adc_set_gclk(GCLK_CLKCTRL_GEN_GCLK3);
+
+    // averaged results need the 16-bit accumulator
+    const uint32_t ressel = plan.samplenum > 0 ? ADC_CTRLB_RESSEL_16BIT :
+                            _resolution == 12  ? ADC_CTRLB_RESSEL_12BIT :
+                            _resolution == 10  ? ADC_CTRLB_RESSEL_10BIT :
+                                                 ADC_CTRLB_RESSEL_8BIT;
+    ADC->CTRLB.reg = (_saved_ctrlb & ADC_CTRLB_CORREN) | ADC_CTRLB_PRESCALER(plan.prescaler) | ressel;
+    adc_sync();
+    ADC->SAMPCTRL.reg = plan.samplen;
+    ADC->AVGCTRL.reg = ADC_AVGCTRL_SAMPLENUM(plan.samplenum) | ADC_AVGCTRL_ADJRES(plan.adjres);
+    adc_sync();
+
+    // keep the gain and negative input from analogReference()
+    const uint32_t inputctrl = (_saved_inputctrl & (ADC_INPUTCTRL_GAIN_Msk | ADC_INPUTCTRL_MUXNEG_Msk)) |
+                               ADC_INPUTCTRL_MUXPOS(_first_ain) |
+                               ADC_INPUTCTRL_INPUTSCAN(_frame_size - 1) |
+                               ADC_INPUTCTRL_INPUTOFFSET(0);
+    ADC->INPUTCTRL.reg = inputctrl;
+    adc_sync();
+
+    ADC->CTRLA.bit.ENABLE = 1;
+    adc_sync();
+
+    // discard the first conversion, then rewind INPUTOFFSET which it advanced
+    ADC->SWTRIG.reg = ADC_SWTRIG_START;
+    while (!ADC->INTFLAG.bit.RESRDY);
+    (void)ADC->RESULT.reg;
+    ADC->INPUTCTRL.reg = inputctrl;
+    adc_sync();
+    ADC->INTFLAG.reg = ADC_INTFLAG_MASK;
+
+    ADC->EVCTRL.reg = ADC_EVCTRL_STARTEI;
+    adc_sync();
+
+    _running = true;
+    _dma.startJob();
+    start_timer(rate);
+    return true;
+}
+
+void AdcScan::stop(void)
+{
+    if (!_running)
+        return;
+
+    TcCount16 *tc16 = &_tc->COUNT16;
+    tc16->CTRLA.reg &= ~TC_CTRLA_ENABLE;
+    while (tc16->STATUS.bit.SYNCBUSY);
+    event_route_disconnect(_event_channel);
+    _event_channel = -1;
+    _dma.abort();
+
+    ADC->CTRLA.bit.ENABLE = 0;
+    adc_sync();
+    ADC->EVCTRL.reg = 0;
+    ADC->CTRLB.reg = _saved_ctrlb;
+    adc_sync();
+    ADC->SAMPCTRL.reg = _saved_sampctrl;
+    ADC->AVGCTRL.reg = _saved_avgctrl;
+    adc_sync();
+    ADC->INPUTCTRL.reg = _saved_inputctrl;
+    adc_sync();
+    adc_set_gclk(GCLK_CLKCTRL_GEN_GCLK0);
+    ADC->INTFLAG.reg = ADC_INTFLAG_MASK;
+    analogReadInvalidate();
+
+    _running = false;
+}
+
+void AdcScan::start_timer(uint32_t rate)
+{
+    // event_gen_tc_ovf() already rejected anything but TC3-TC5
+    const uint32_t clk_id = (_tc == TC3) ? GCLK_CLKCTRL_ID_TCC2_TC3_Val : GCLK_CLKCTRL_ID_TC4_TC5_Val;
+    GCLK->CLKCTRL.reg = (uint16_t)(GCLK_CLKCTRL_CLKEN | GCLK_CLKCTRL_GEN_GCLK0 | GCLK_CLKCTRL_ID(clk_id));
+    while (GCLK->STATUS.bit.SYNCBUSY);
+
+    // smallest prescaler where the period fits in 16 bits, so the rate is as
+    // close as it can be
+    const uint32_t ticks = (F_CPU + rate / 2) / rate;
+    uint32_t prescaler = 0;
+    while (prescaler < 7 && (ticks >> tc_prescaler_shift(prescaler)) > 65536)
+        prescaler++;
+
+    TcCount16 *tc16 = &_tc->COUNT16;
+    tc16->CTRLA.reg &= ~TC_CTRLA_ENABLE;
+    while (tc16->STATUS.bit.SYNCBUSY);
+    tc16->CTRLA.reg = TC_CTRLA_SWRST;
+    while (tc16->STATUS.bit.SYNCBUSY);
+    while (tc16->CTRLA.bit.SWRST);
+
+    tc16->CTRLA.reg =
+        TC_CTRLA_MODE(TC_CTRLA_MODE_COUNT16_Val)    |     // 16-bit counter mode
+        TC_CTRLA_WAVEGEN(TC_CTRLA_WAVEGEN_MFRQ_Val) |     // match frequency mode
+        TC_CTRLA_PRESCALER(prescaler);
+    tc16->CC[0].reg = (uint16_t)((ticks >> tc_prescaler_shift(prescaler)) - 1);
+    while (tc16->STATUS.bit.SYNCBUSY);
+
+    // overflow event to the ADC, no interrupt
+    tc16->EVCTRL.reg = TC_EVCTRL_OVFEO;
+    tc16->CTRLA.reg |= TC_CTRLA_ENABLE;
+    while (tc16->STATUS.bit.SYNCBUSY);
+}
+
+// Average each run of 1 << shift frames into one, in place at the start of
+// the block. Frame i is written after frames i * (1 << shift) onward are read.
+static uint32_t decimate(uint16_t *samples, uint32_t frames, unsigned int frame_size,
+                         unsigned int shift)
+{
+    const uint32_t out_frames = frames >> shift;
+    const uint32_t count = 1ul << shift;
+    for (uint32_t i = 0; i < out_frames; i++)
+    {
+        const uint16_t *in = samples + (i << shift) * frame_size;
+        uint16_t *out = samples + i * frame_size;
+        for (unsigned int ch = 0; ch < frame_size; ch++)
+        {
+            uint32_t sum = 0;
+            for (uint32_t j = 0; j < count; j++)
+                sum += in[j * frame_size + ch];
+            out[ch] = (sum + count / 2) >> shift;
+        }
+    }
+    return out_frames;
+}
+
+void AdcScan::dma_callback(void *ctx)
+{
+    AdcScan *scan = static_cast<AdcScan*>(ctx);
+    const uint32_t block = scan->_blocks;
+    scan->_blocks = block + 1;
+    if (scan->_callback != NULL)
+    {
+        // DMA is filling the other half, so this one can be decimated in place
+        uint16_t *samples = scan->_buffer + (block & 1) * scan->_block_len;
+        uint32_t frames = scan->_block_len / scan->_frame_size;
+        if (scan->_decimation_shift > 0)
+            frames = decimate(samples, frames, scan->_frame_size, scan->_decimation_shift);
+        scan->_callback(samples, frames, scan->_ctx);
+    }
+}
@@ -0,0 +1,139 @@
+/*******************************************************************************
+ * Timer-triggered multichannel ADC scan with DMA double buffering
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+/*
+ * The ADC is configured once for a list of pins and converts them with
+ * INPUTSCAN: each START converts the input at MUXPOS + INPUTOFFSET and moves
+ * INPUTOFFSET to the next one, wrapping after the last. A TC running in MFRQ
+ * mode generates START through EVSYS at exactly frame_rate * frame_size(), and
+ * DMA copies each RESULT into the caller's buffer, so the CPU isn't involved
+ * until a block of frames is complete.
+ *
+ * INPUTSCAN covers a contiguous range of AIN numbers, so a frame is every
+ * input from the lowest to the highest AIN in the pin list, including any in
+ * between that weren't asked for. index() gives a pin's position in the frame.
+ * A1-A4 are AIN2-AIN5, so scanning them wastes nothing; A0 (AIN0) or A5
+ * (AIN10) widen the frame.
+ *
+ * The buffer holds two blocks. The callback runs from the DMAC interrupt when
+ * one is full, while DMA fills the other, so it has one block time to use the
+ * samples:
+ *
+ *   static const uint8_t pins[] = { A1, A2, A3, A4 };
+ *   static uint16_t buf[2 * 64 * 4];
+ *   static AdcScan scan(TC4);
+ *   ...
+ *   scan.begin(pins, 4);
+ *   scan.start(10000, buf, 64, block_done, NULL);   // 10k frames/s, 40 ksps
+ *
+ * While running the ADC clock is GCLK3 (OSC8M) / 4 = 2MHz, the fastest
+ * in-spec clock available. Conversion time, plus a margin for OSC8M's error
+ * and the START event sync, limits the total rate to about 222 ksps at 12 bits
+ * and 307 ksps at 8 bits, and start() rejects faster rates.
+ * stop() puts the ADC back the way analogRead() left it.
+ *
+ * Resolutions of 13-16 bits use hardware averaging, see AdcOversample.h. By
+ * default the sampling time and number of samples averaged are chosen by
+ * start() to fill the time between conversions, so slower rates give quieter
+ * results at no CPU cost; 12 bits at 1 ksps averages 128 conversions. Below
+ * what 1024 samples can fill, start() can also decimate, averaging that many
+ * frames into one before the callback:
+ *
+ *   scan.begin(pins, 4, 16);
+ *   scan.start(10, buf, 10, block_done, NULL, 16);   // 10 frames/s, 16 bits
+ */
+
+#ifndef ADCSCAN_H
+#define ADCSCAN_H
+
+#include <sam.h>
+#include <stdint.h>
+#include "Adafruit_ZeroDMA.h"
+#include "AdcOversample.h"
+
+// Called from the DMAC interrupt with a block of frames interleaved by
+// frame_size(), i.e. samples[frame * frame_size() + index(pin)]
+typedef void (*AdcScanCallback)(const uint16_t *samples, uint32_t frames, void *ctx);
+
+class AdcScan
+{
+    public:
+        // tc is the trigger timer, which can't be used for anything else
+        AdcScan(Tc *tc) : _tc(tc), _frame_size(0), _first_ain(0), _resolution(12),
+                          _samplen(ADC_OVERSAMPLE_SAMPLEN_AUTO), _desc{NULL, NULL}, _event_channel(-1), _running(false) { }
+
+        // Set the pins to scan and the resolution (8, 10 or 12-16 bits).
+        // samplen is the SAMPCTRL value, the sampling time is (samplen + 1) / 2
+        // ADC clocks (250ns each). A fixed samplen also turns off the extra
+        // averaging. Returns false if a pin isn't analog or the range is too
+        // wide.
+        bool begin(const uint8_t *pins, unsigned int count, unsigned int resolution=12,
+                   unsigned int samplen=ADC_OVERSAMPLE_SAMPLEN_AUTO);
+
+        // Start sampling into buffer. frame_rate and frames_per_block count
+        // frames after decimation, a power of 2 (1 for none), and buffer holds
+        // 2 * frames_per_block * decimation * frame_size() samples. Returns
+        // false if not begun, already running, or the rate is faster than
+        // max_rate().
+        bool start(uint32_t frame_rate, uint16_t *buffer, uint32_t frames_per_block,
+                   AdcScanCallback callback, void *ctx=NULL, uint32_t decimation=1);
+        void stop(void);
+
+        inline bool running(void) const { return _running; }
+
+        // samples per frame, and a pin's position in the frame (-1 if not scanned)
+        inline unsigned int frame_size(void) const { return _frame_size; }
+        int index(uint32_t pin) const;
+
+        // fastest total rate (frame_rate * decimation * frame_size) for the
+        // current resolution and sampling time
+        uint32_t max_rate(void) const;
+
+        // blocks completed since start()
+        inline uint32_t blocks(void) const { return _blocks; }
+
+    private:
+        Tc *_tc;
+        Adafruit_ZeroDMA _dma;
+        uint8_t _frame_size;
+        uint8_t _first_ain;
+        uint8_t _resolution;
+        uint8_t _samplen;
+        DmacDescriptor *_desc[2];
+        int _event_channel;
+        volatile bool _running;
+
+        uint16_t *_buffer;
+        uint32_t _block_len;
+        uint8_t _decimation_shift;
+        AdcScanCallback _callback;
+        void *_ctx;
+        volatile uint32_t _blocks;
+
+        // ADC registers saved by start() and restored by stop()
+        uint16_t _saved_ctrlb;
+        uint8_t _saved_sampctrl;
+        uint8_t _saved_avgctrl;
+        uint32_t _saved_inputctrl;
+
+        void start_timer(uint32_t rate);
+        static void dma_callback(void *ctx);
+};
+
+#endif // ADCSCAN_H
@@ -0,0 +1,149 @@
+/*
+ * adc_oversample_test.cc: console application to check adc_oversample_plan()
+ * for every resolution over a sweep of rates: the settings must fit in the
+ * time per result with the safety margin left over, give the requested number
+ * of bits, and use the most samples that fit. Extension is .cc instead of .cpp so that the samd21
+ * Makefile ignores it.
+ *
+ * Build and run:
+ *   g++ -O2 -Wall -o adc_oversample_test adc_oversample_test.cc
+ *   ./adc_oversample_test
+ */
+
+#include <stdio.h>
+
+#include "AdcOversample.h"
+
+// every check has the plan's inputs in scope
+#define CHECK_CONTEXT() printf("gclk %u rate %u bits %u samplen %u: ", gclk, rate, bits, samplen)
+#include "../host_test.h"
+
+// AdcScan's GCLK3, and GCLK0 for a plain analogRead() setup
+static const uint32_t gclks[] = { 8000000, 48000000 };
+static const unsigned int resolutions[] = { 8, 10, 12, 13, 14, 15, 16 };
+
+// bits left in the 16-bit result register after both shifts
+static unsigned int result_bits(const AdcOversamplePlan *p, unsigned int bits)
+{
+    if (p->samplenum == 0)
+        return bits;
+    const unsigned int auto_shift = p->samplenum > 4 ? p->samplenum - 4 : 0;
+    return 12 + p->samplenum - auto_shift - p->adjres;
+}
+
+// At least 1/16 of the trigger period plus the START sync time is left idle,
+// more than OSC8M's 2% error, so conversions can't overrun the next trigger
+static void check_margin(uint32_t gclk, uint32_t rate, unsigned int bits, unsigned int samplen,
+                         uint32_t period, uint32_t used)
+{
+    CHECK(period - used >= period / 16 + ADC_OVERSAMPLE_SYNC_HALF_CLOCKS,
+          "only %u of %u half clocks idle", period - used, period);
+    // the ADC clock 2% fast still fits, the trigger rate being exact
+    CHECK(used * 102 <= period * 100, "overruns with a 2%% slow ADC clock");
+}
+
+static void check(uint32_t gclk, uint32_t rate, unsigned int bits, unsigned int samplen)
+{
+    AdcOversamplePlan p = {};
+    const bool ok = adc_oversample_plan(gclk, rate, bits, samplen, &p);
+    const bool fits = rate <= adc_oversample_max_rate(gclk, bits, samplen);
+    CHECK(ok == fits, "plan %d, max rate %u", ok, adc_oversample_max_rate(gclk, bits, samplen));
+    if (!ok)
+        return;
+
+    const uint32_t adc_hz = adc_oversample_clk_hz(gclk, p.prescaler);
+    const uint32_t period = 2 * adc_hz / rate;
+    const uint32_t budget = adc_oversample_budget(adc_hz, rate);
+    const uint32_t used = adc_oversample_half_clocks(p.samplen, bits) << p.samplenum;
+
+    CHECK(adc_hz <= ADC_OVERSAMPLE_MAX_CLK_HZ, "ADC clock %u", adc_hz);
+    CHECK(p.prescaler == 0 || adc_oversample_clk_hz(gclk, p.prescaler - 1) > ADC_OVERSAMPLE_MAX_CLK_HZ,
+          "prescaler %u isn't the fastest", p.prescaler);
+    CHECK(used <= budget, "uses %u of %u half clocks", used, budget);
+    check_margin(gclk, rate, bits, samplen, period, used);
+    CHECK(p.samplen <= ADC_OVERSAMPLE_MAX_SAMPLEN, "samplen %u", p.samplen);
+    CHECK(p.samplenum <= ADC_OVERSAMPLE_MAX_LOG2N, "samplenum %u", p.samplenum);
+    CHECK(p.adjres <= 7, "adjres %u", p.adjres);
+    CHECK(result_bits(&p, bits) == bits, "%u result bits", result_bits(&p, bits));
+    CHECK(p.samplenum >= adc_oversample_min_log2n(bits), "samplenum %u too few", p.samplenum);
+
+    if (samplen != ADC_OVERSAMPLE_SAMPLEN_AUTO)
+    {
+        CHECK(p.samplen == samplen, "samplen changed to %u", p.samplen);
+        CHECK(p.samplenum == adc_oversample_min_log2n(bits), "samplenum %u with fixed samplen", p.samplenum);
+        return;
+    }
+
+    // nothing more fits: another doubling of the samples, or one more
+    // sampling half clock
+    if (bits >= 12 && p.samplenum < ADC_OVERSAMPLE_MAX_LOG2N)
+        CHECK((adc_oversample_half_clocks(0, bits) << (p.samplenum + 1)) > budget,
+              "room for more than %u samples", 1u << p.samplenum);
+    if (p.samplen < ADC_OVERSAMPLE_MAX_SAMPLEN)
+        CHECK((adc_oversample_half_clocks(p.samplen + 1, bits) << p.samplenum) > budget,
+              "room for more than samplen %u", p.samplen);
+}
+
+int main(void)
+{
+    unsigned long plans = 0;
+
+    for (uint32_t gclk : gclks)
+    {
+        for (unsigned int bits : resolutions)
+        {
+            for (uint32_t rate = 1; rate <= 400000; rate += (rate < 1000 ? 1 : rate / 100))
+            {
+                check(gclk, rate, bits, ADC_OVERSAMPLE_SAMPLEN_AUTO);
+                check(gclk, rate, bits, 0);
+                check(gclk, rate, bits, ADC_OVERSAMPLE_MAX_SAMPLEN);
+                plans += 3;
+            }
+        }
+    }
+
+    // the AVGCTRL table from the datasheet, at the fastest rate for each
+    static const unsigned int adjres[] = { 0, 1, 2, 1, 0 };
+    for (unsigned int e = 0; e <= 4; e++)
+    {
+        AdcOversamplePlan p = {};
+        const uint32_t gclk = 8000000, rate = adc_oversample_max_rate(gclk, 12 + e, 0);
+        const unsigned int bits = 12 + e, samplen = 0;
+        const bool ok = adc_oversample_plan(gclk, rate, bits, samplen, &p);
+        CHECK(ok && p.samplenum == 2 * e && p.adjres == adjres[e],
+              "samplenum %u adjres %u", p.samplenum, p.adjres);
+        plans++;
+    }
+
+    // 130 frames/s at 12 bits used to leave under 0.2% of the period idle
+    {
+        AdcOversamplePlan p = {};
+        const uint32_t gclk = 8000000, rate = 130;
+        const unsigned int bits = 12, samplen = ADC_OVERSAMPLE_SAMPLEN_AUTO;
+        const bool ok = adc_oversample_plan(gclk, rate, bits, samplen, &p);
+        const uint32_t period = 2 * adc_oversample_clk_hz(gclk, p.prescaler) / rate;
+        const uint32_t used = adc_oversample_half_clocks(p.samplen, bits) << p.samplenum;
+        CHECK(ok, "no plan");
+        check_margin(gclk, rate, bits, samplen, period, used);
+        plans++;
+    }
+
+    // rejected settings
+    {
+        AdcOversamplePlan p = {};
+        const uint32_t gclk = 8000000, rate = 1000;
+        unsigned int bits = 11, samplen = 0;
+        CHECK(!adc_oversample_plan(gclk, rate, bits, samplen, &p), "11 bits accepted");
+        bits = 17;
+        CHECK(!adc_oversample_plan(gclk, rate, bits, samplen, &p), "17 bits accepted");
+        bits = 12;
+        samplen = 64;
+        CHECK(!adc_oversample_plan(gclk, rate, bits, samplen, &p), "samplen 64 accepted");
+        samplen = 0;
+        CHECK(!adc_oversample_plan(gclk, 0, bits, samplen, &p), "rate 0 accepted");
+        plans += 4;
+    }
+
+    printf("%lu plans checked\n", plans);
+    return check_result();
+}
@@ -0,0 +1,137 @@
+/*******************************************************************************
+ * SAMD21 BinLog library. Deferred binary logging with host-side formatting
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include <sam.h>
+#include "BinLog.h"
+#include "delay.h"
+
+#if (BINLOG_BUFFER_WORDS & (BINLOG_BUFFER_WORDS - 1)) != 0
+#error BINLOG_BUFFER_WORDS must be a power of 2
+#endif
+
+#define BINLOG_MASK (BINLOG_BUFFER_WORDS - 1)
+
+/*
+ * Entry layout in the ring buffer:
+ *   word 0: format ID (bits 0-23) and argument count (bits 24-31)
+ *   word 1: micros() timestamp
+ *   words 2..n+1: arguments
+ *
+ * head and tail are free-running word counters, only wrapped when indexing
+ * the buffer. Producers can be interrupted by other producers, so they
+ * reserve and fill their space with interrupts masked (a few dozen cycles).
+ * There's a single consumer, which only ever writes tail and so needs no lock.
+ */
+static uint32_t binlog_buf[BINLOG_BUFFER_WORDS];
+static volatile uint32_t binlog_head = 0;
+static volatile uint32_t binlog_tail = 0;
+static volatile uint32_t binlog_drop_count = 0;
+static uint32_t binlog_drop_reported = 0;
+
+void binlog_write(const char *fmt, const uint32_t *args, uint32_t nargs)
+{
+    const uint32_t header = ((uint32_t)(uintptr_t)fmt & BINLOG_ID_DROPPED) | (nargs << 24);
+    const uint32_t timestamp = micros();
+    const uint32_t len = nargs + 2;
+
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    uint32_t head = binlog_head;
+    if (BINLOG_BUFFER_WORDS - (head - binlog_tail) < len)
+    {
+        binlog_drop_count++;
+        __set_PRIMASK(primask);
+        return;
+    }
+
+    binlog_buf[head++ & BINLOG_MASK] = header;
+    binlog_buf[head++ & BINLOG_MASK] = timestamp;
+    while (nargs--)
+        binlog_buf[head++ & BINLOG_MASK] = *args++;
+    binlog_head = head;
+
+    __set_PRIMASK(primask);
+}
+
+// Frame on the wire, all multi-byte fields little-endian:
+//   sync byte, nargs, 3-byte ID, 4-byte timestamp, 4 bytes per arg, checksum
+// The checksum is the 8-bit sum of every byte after the sync byte.
+static void send_frame(Print &out, uint32_t header, uint32_t timestamp,
+                       const uint32_t *args, uint32_t nargs)
+{
+    uint8_t frame[1 + 4 + 4 + (4 * BINLOG_MAX_ARGS) + 1];
+    uint8_t *p = frame;
+
+    *p++ = BINLOG_FRAME_SYNC;
+    *p++ = (uint8_t)nargs;
+    *p++ = (uint8_t)(header);
+    *p++ = (uint8_t)(header >> 8);
+    *p++ = (uint8_t)(header >> 16);
+    memcpy(p, &timestamp, 4);
+    p += 4;
+    memcpy(p, args, 4 * nargs);
+    p += 4 * nargs;
+
+    uint8_t sum = 0;
+    for (const uint8_t *q = frame + 1; q < p; q++)
+        sum += *q;
+    *p++ = sum;
+
+    out.write(frame, p - frame);
+}
+
+size_t binlog_drain(Print &out, size_t max_entries)
+{
+    size_t count = 0;
+
+    uint32_t dropped = binlog_drop_count;
+    if (dropped != binlog_drop_reported)
+    {
+        uint32_t lost = dropped - binlog_drop_reported;
+        send_frame(out, BINLOG_ID_DROPPED, micros(), &lost, 1);
+        binlog_drop_reported = dropped;
+    }
+
+    uint32_t tail = binlog_tail;
+    while (count < max_entries && tail != binlog_head)
+    {
+        // make sure the entry contents are read after head
+        __DMB();
+
+        uint32_t args[BINLOG_MAX_ARGS];
+        uint32_t header = binlog_buf[tail++ & BINLOG_MASK];
+        uint32_t timestamp = binlog_buf[tail++ & BINLOG_MASK];
+        uint32_t nargs = header >> 24;
+        for (uint32_t i = 0; i < nargs; i++)
+            args[i] = binlog_buf[tail++ & BINLOG_MASK];
+
+        // release the space before the (possibly slow) write
+        binlog_tail = tail;
+        send_frame(out, header, timestamp, args, nargs);
+        count++;
+    }
+
+    return count;
+}
+
+uint32_t binlog_dropped(void)
+{
+    return binlog_drop_count;
+}
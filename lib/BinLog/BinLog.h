@@ -0,0 +1,117 @@
+/*******************************************************************************
+ * SAMD21 BinLog library. Deferred binary logging with host-side formatting
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+/*
+ * BINLOG("fmt", args...) doesn't format anything on the MCU. It copies a
+ * format string ID, a micros() timestamp, and the raw 32-bit arguments into
+ * a ring buffer, which is safe to call from any ISR or thread context.
+ * Later, binlog_drain() is called from loop() (or some other low-priority
+ * context) to send the entries out as binary frames over any Print object.
+ *
+ * Format strings live in the .binlog_fmt section, which the linker scripts
+ * mark as INFO (not loaded to flash) and start at address 0. The address of
+ * each string is its ID, and scripts/binlog-decode.py reads the strings back
+ * out of the ELF file to format the messages on the host.
+ *
+ * Arguments are stored as 32-bit words. Integers, enums, and pointers are
+ * stored as-is, floats and doubles are stored as single-precision floats.
+ * %s is only decodable for pointers to constant strings in flash.
+ */
+
+#ifndef BINLOG_H
+#define BINLOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+#include "Print.h"
+
+// Ring buffer size in 32-bit words, must be a power of 2.
+// Each entry takes 2 words plus 1 word per argument.
+#ifndef BINLOG_BUFFER_WORDS
+#define BINLOG_BUFFER_WORDS 256
+#endif
+
+#define BINLOG_MAX_ARGS 8
+
+// Sync byte at the start of every frame sent by binlog_drain
+#define BINLOG_FRAME_SYNC 0xa5
+
+// Frame ID reported when entries were dropped because the buffer was full.
+// The single argument is the number of entries lost.
+#define BINLOG_ID_DROPPED 0xffffffUL
+
+#define BINLOG(fmt, ...) do {                                                  \
+        static const char _binlog_fmt[]                                         \
+            __attribute__((section(".binlog_fmt"), used)) = fmt;                \
+        binlog_log(_binlog_fmt, ##__VA_ARGS__);                                 \
+    } while (0)
+
+namespace binlog_detail {
+
+template<typename T>
+inline typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value, uint32_t>::type
+arg(T value)
+{
+    static_assert(sizeof(T) <= sizeof(uint32_t), "BINLOG arguments must be 32 bits or smaller");
+    return (uint32_t)value;
+}
+
+inline uint32_t arg(float value)
+{
+    uint32_t word;
+    memcpy(&word, &value, sizeof(word));
+    return word;
+}
+
+inline uint32_t arg(double value)
+{
+    return arg((float)value);
+}
+
+template<typename T>
+inline uint32_t arg(T *value)
+{
+    return (uint32_t)(uintptr_t)value;
+}
+
+} // namespace binlog_detail
+
+// Low-level entry point used by BINLOG. fmt must point into .binlog_fmt.
+void binlog_write(const char *fmt, const uint32_t *args, uint32_t nargs);
+
+template<typename... Args>
+inline void binlog_log(const char *fmt, Args... args)
+{
+    static_assert(sizeof...(Args) <= BINLOG_MAX_ARGS, "too many BINLOG arguments");
+    // extra element so the array is never zero-length
+    const uint32_t words[] = { binlog_detail::arg(args)..., 0 };
+    binlog_write(fmt, words, sizeof...(Args));
+}
+
+// Send up to max_entries buffered entries to out. Returns the number sent.
+// Only one context may drain at a time.
+size_t binlog_drain(Print &out, size_t max_entries=SIZE_MAX);
+
+// Number of entries dropped because the ring buffer was full
+uint32_t binlog_dropped(void);
+
+#endif // BINLOG_H
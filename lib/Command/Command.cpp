@@ -0,0 +1,191 @@
+/*******************************************************************************
+ * Table-driven serial command dispatcher
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include "Command.h"
+
+// ctype.h functions go through a locale table in newlib, these don't
+static inline bool is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static inline bool is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static inline const char *skip_space(const char *s)
+{
+    while (is_space(*s))
+        s++;
+    return s;
+}
+
+static inline int hex_value(char c)
+{
+    if (is_digit(c)) return c - '0';
+    c = command_upper(c);
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool CommandArgs::next_int(int32_t *value)
+{
+    const char *p = skip_space(_pos);
+    bool negative = false;
+
+    if (*p == '-' || *p == '+')
+        negative = (*p++ == '-');
+
+    uint32_t result = 0;
+    bool overflow = false;
+    const char *digits;
+    const bool hex = (p[0] == '0' && (p[1] == 'x' || p[1] == 'X') && hex_value(p[2]) >= 0);
+    if (hex)
+    {
+        p += 2;
+        digits = p;
+        int d;
+        while ((d = hex_value(*p)) >= 0)
+        {
+            overflow |= (result >> 28) != 0;
+            result = (result << 4) | d;
+            p++;
+        }
+    }
+    else
+    {
+        digits = p;
+        while (is_digit(*p))
+        {
+            const uint32_t d = *p++ - '0';
+            overflow |= result > (UINT32_MAX - d) / 10;
+            result = result * 10 + d;
+        }
+    }
+
+    // need at least one digit, and the number has to end at a word boundary
+    if (p == digits || (*p != '\0' && !is_space(*p)))
+        return false;
+
+    // allow hex up to 0xffffffff for bit masks, but decimal must fit in int32_t
+    if (overflow || (!hex && result > (negative ? 0x80000000u : 0x7fffffffu)))
+        return false;
+
+    *value = negative ? (int32_t)(0u - result) : (int32_t)result;
+    _pos = p;
+    return true;
+}
+
+bool CommandArgs::next_int(int32_t *value, int32_t min, int32_t max)
+{
+    const char *saved = _pos;
+    int32_t v;
+    if (!next_int(&v))
+        return false;
+    if (v < min || v > max)
+    {
+        _pos = saved;
+        return false;
+    }
+    *value = v;
+    return true;
+}
+
+size_t CommandArgs::next_word(char *buf, size_t bufsize)
+{
+    const char *p = skip_space(_pos);
+    size_t len = 0;
+
+    while (*p != '\0' && !is_space(*p))
+    {
+        if (len + 1 < bufsize)
+            buf[len] = *p;
+        len++;
+        p++;
+    }
+    if (bufsize)
+        buf[len < bufsize ? len : bufsize - 1] = '\0';
+
+    _pos = p;
+    return len;
+}
+
+const char *CommandArgs::rest(void)
+{
+    _pos = skip_space(_pos);
+    return _pos;
+}
+
+// compare a non-terminated word against a command name, case-insensitive
+static int compare_word(const char *word, size_t len, const char *name)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        int diff = command_upper(word[i]) - command_upper(name[i]);
+        if (diff != 0)
+            return diff;
+    }
+    return name[len] == '\0' ? 0 : -1;
+}
+
+const Command *CommandTable::find(const char *name, size_t len) const
+{
+    size_t lo = 0, hi = _count;
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+        int cmp = compare_word(name, len, _table[mid].name);
+        if (cmp == 0)
+            return &_table[mid];
+        if (cmp < 0)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    return NULL;
+}
+
+CommandStatus CommandTable::dispatch(const char *line) const
+{
+    const char *name = skip_space(line);
+    const char *end = name;
+    while (*end != '\0' && !is_space(*end))
+        end++;
+
+    if (end == name)
+        return CMD_EMPTY;
+
+    const Command *cmd = find(name, end - name);
+
+    // a one-letter command can opt in to having its number attached, e.g. "L5"
+    if (cmd == NULL && end - name > 1 && (is_digit(name[1]) || name[1] == '-' || name[1] == '+'))
+    {
+        cmd = find(name, 1);
+        if (cmd != NULL && (cmd->flags & CMD_ATTACHED_NUMBER))
+            end = name + 1;
+        else
+            cmd = NULL;
+    }
+    if (cmd == NULL)
+        return CMD_UNKNOWN;
+
+    CommandArgs args(end);
+    return cmd->handler(args) ? CMD_OK : CMD_BAD_ARGS;
+}
@@ -0,0 +1,147 @@
+/*******************************************************************************
+ * Table-driven serial command dispatcher
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+/*
+ * Commands are a name (the first word of the line, case-insensitive) and a
+ * handler which parses the rest of the line with CommandArgs. The table lives
+ * in flash, must be sorted by name, and is searched with a binary search.
+ * A one-letter command flagged CMD_ATTACHED_NUMBER can also have its number
+ * right after the letter, so "L5" is the same as "L 5". This is only tried
+ * when the whole word isn't a command, and other commands never match a
+ * mistyped word this way.
+ *
+ *   static bool cmd_led(CommandArgs &args)
+ *   {
+ *       int32_t state;
+ *       if (!args.next_int(&state) || !args.done())
+ *           return false;
+ *       ...
+ *       return true;
+ *   }
+ *
+ *   static constexpr Command commands[] = {
+ *       { "B", cmd_brightness, 0 },
+ *       { "L", cmd_led, CMD_ATTACHED_NUMBER },
+ *   };
+ *   static_assert(command_table_sorted(commands), "commands must be sorted");
+ *   static const CommandTable command_table(commands);
+ *
+ *   if (command_table.dispatch(line) != CMD_OK) ...
+ */
+
+#ifndef COMMAND_H
+#define COMMAND_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Tokenizer and argument parser for the part of the line after the command name
+class CommandArgs
+{
+    public:
+        CommandArgs(const char *str) : _pos(str) { }
+
+        // Parse a decimal or 0x-prefixed hex integer with optional sign.
+        // Returns false (without consuming anything) if there isn't one.
+        bool next_int(int32_t *value);
+
+        // Like next_int, but also fail if the value is outside [min, max]
+        bool next_int(int32_t *value, int32_t min, int32_t max);
+
+        // Copy the next whitespace-separated word into buf (truncated and always
+        // null-terminated). Returns the length of the word, 0 if there isn't one.
+        size_t next_word(char *buf, size_t bufsize);
+
+        // The unparsed remainder of the line, with leading whitespace skipped
+        const char *rest(void);
+
+        // True if only whitespace remains
+        bool done(void) { return *rest() == '\0'; }
+
+    private:
+        const char *_pos;
+};
+
+typedef bool (*CommandHandler)(CommandArgs &args);
+
+// Command flags
+enum : uint8_t {
+    // one-letter command whose number can follow the letter without a space
+    CMD_ATTACHED_NUMBER = 0x01,
+};
+
+struct Command
+{
+    const char *name;
+    CommandHandler handler;
+    uint8_t flags;
+};
+
+enum CommandStatus {
+    CMD_OK = 0,
+    CMD_EMPTY,          // blank line
+    CMD_UNKNOWN,        // no command with that name
+    CMD_BAD_ARGS,       // the handler returned false
+};
+
+// constexpr helpers for the static_assert that a table is sorted
+constexpr char command_upper(char c)
+{
+    return (c >= 'a' && c <= 'z') ? c - 'a' + 'A' : c;
+}
+
+constexpr int command_compare(const char *a, const char *b)
+{
+    while (*a && command_upper(*a) == command_upper(*b))
+    {
+        a++;
+        b++;
+    }
+    return command_upper(*a) - command_upper(*b);
+}
+
+template<size_t N>
+constexpr bool command_table_sorted(const Command (&table)[N])
+{
+    for (size_t i = 1; i < N; i++)
+    {
+        if (command_compare(table[i-1].name, table[i].name) >= 0)
+            return false;
+    }
+    return true;
+}
+
+class CommandTable
+{
+    public:
+        template<size_t N>
+        constexpr CommandTable(const Command (&table)[N]) : _table(table), _count(N) { }
+
+        // Look up a command name, NULL if not found
+        const Command *find(const char *name, size_t len) const;
+
+        // Parse and run one command line
+        CommandStatus dispatch(const char *line) const;
+
+    private:
+        const Command *_table;
+        size_t _count;
+};
+
+#endif // COMMAND_H
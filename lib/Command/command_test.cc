@@ -0,0 +1,169 @@
+/*
+ * command_test.cc: console application to check CommandTable dispatch and the
+ * CommandArgs number and word parsing, including the attached numbers of
+ * serial-events' old sscanf syntax ("L5", "B0x10").
+ * Extension is .cc instead of .cpp so that the samd21 Makefile ignores it.
+ *
+ * Build and run:
+ *   g++ -O2 -Wall -Wextra -std=gnu++14 -o command_test command_test.cc Command.cpp
+ *   ./command_test
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "Command.h"
+#include "../host_test.h"
+
+// what the last handler saw
+static char last_cmd;
+static int32_t last_value;
+
+static bool cmd_number(char name, CommandArgs &args)
+{
+    int32_t value;
+    if (!args.next_int(&value) || !args.done())
+        return false;
+    last_cmd = name;
+    last_value = value;
+    return true;
+}
+
+static bool cmd_none(char name, CommandArgs &args)
+{
+    if (!args.done())
+        return false;
+    last_cmd = name;
+    last_value = 0;
+    return true;
+}
+
+static bool cmd_b(CommandArgs &args) { return cmd_number('B', args); }
+static bool cmd_l(CommandArgs &args) { return cmd_number('L', args); }
+static bool cmd_led(CommandArgs &args) { return cmd_number('E', args); }
+static bool cmd_q(CommandArgs &args) { return cmd_none('Q', args); }
+static bool cmd_x(CommandArgs &args) { return cmd_number('X', args); }
+
+static constexpr Command commands[] = {
+    { "B", cmd_b, CMD_ATTACHED_NUMBER },
+    { "L", cmd_l, CMD_ATTACHED_NUMBER },
+    { "LED", cmd_led, 0 },
+    { "Q", cmd_q, 0 },
+    { "X", cmd_x, 0 },
+};
+static_assert(command_table_sorted(commands), "commands table is not sorted");
+static const CommandTable command_table(commands);
+
+// the sorted check is case-insensitive and rejects duplicates
+static constexpr Command unsorted[] = { { "b", cmd_b, 0 }, { "A", cmd_b, 0 } };
+static constexpr Command duplicate[] = { { "B", cmd_b, 0 }, { "b", cmd_b, 0 } };
+static constexpr Command mixed_case[] = { { "a", cmd_b, 0 }, { "B", cmd_b, 0 } };
+static_assert(!command_table_sorted(unsorted), "unsorted table passed");
+static_assert(!command_table_sorted(duplicate), "duplicate names passed");
+static_assert(command_table_sorted(mixed_case), "mixed case table failed");
+
+static void check_dispatch(const char *line, CommandStatus status, char cmd = 0, int32_t value = 0)
+{
+    last_cmd = 0;
+    last_value = -12345;
+    const CommandStatus got = command_table.dispatch(line);
+    CHECK(got == status, "'%s': status %d, expected %d", line, got, status);
+    if (status == CMD_OK)
+        CHECK(last_cmd == cmd && last_value == value, "'%s': ran %c with %d, expected %c with %d",
+              line, last_cmd ? last_cmd : '-', last_value, cmd, value);
+}
+
+static void check_int(const char *str, bool ok, int32_t expected = 0)
+{
+    CommandArgs args(str);
+    int32_t value = -12345;
+    const bool got = args.next_int(&value);
+    CHECK(got == ok, "'%s': next_int returned %d", str, got);
+    if (ok)
+        CHECK(value == expected, "'%s': %d, expected %d", str, value, expected);
+    else
+        CHECK(value == -12345 && args.rest() == str + strspn(str, " "), "'%s': failed but consumed input", str);
+}
+
+int main(void)
+{
+    // names are whole words and case-insensitive
+    check_dispatch("L 5", CMD_OK, 'L', 5);
+    check_dispatch("  l\t5  ", CMD_OK, 'L', 5);
+    check_dispatch("LED 3", CMD_OK, 'E', 3);
+    check_dispatch("led 3", CMD_OK, 'E', 3);
+    check_dispatch("Q", CMD_OK, 'Q');
+    check_dispatch("LE 3", CMD_UNKNOWN);
+    check_dispatch("LEDS 3", CMD_UNKNOWN);
+    check_dispatch("A", CMD_UNKNOWN);
+    check_dispatch("Z 1", CMD_UNKNOWN);
+    check_dispatch("", CMD_EMPTY);
+    check_dispatch("  \t ", CMD_EMPTY);
+    check_dispatch("L", CMD_BAD_ARGS);
+    check_dispatch("L 5 6", CMD_BAD_ARGS);
+    check_dispatch("L five", CMD_BAD_ARGS);
+    check_dispatch("Q 1", CMD_BAD_ARGS);
+
+    // attached numbers, for commands that allow them
+    check_dispatch("L5", CMD_OK, 'L', 5);
+    check_dispatch("l5", CMD_OK, 'L', 5);
+    check_dispatch("L-1", CMD_OK, 'L', -1);
+    check_dispatch("L+2", CMD_OK, 'L', 2);
+    check_dispatch("B0x10", CMD_OK, 'B', 16);
+    check_dispatch("B255 ", CMD_OK, 'B', 255);
+    check_dispatch("L5 6", CMD_BAD_ARGS);
+    check_dispatch("L5x", CMD_BAD_ARGS);
+    check_dispatch("B0x", CMD_BAD_ARGS);
+    check_dispatch("Lx", CMD_UNKNOWN);
+    check_dispatch("LEDX", CMD_UNKNOWN);
+    // a one-letter command without the flag doesn't take a mistyped word
+    check_dispatch("X5", CMD_UNKNOWN);
+    check_dispatch("Q1", CMD_UNKNOWN);
+    check_dispatch("X 5", CMD_OK, 'X', 5);
+
+    // numbers
+    check_int("0", true, 0);
+    check_int("  42", true, 42);
+    check_int("-42", true, -42);
+    check_int("+42", true, 42);
+    check_int("2147483647", true, 2147483647);
+    check_int("-2147483648", true, -2147483647 - 1);
+    check_int("2147483648", false);
+    check_int("-2147483649", false);
+    check_int("99999999999", false);
+    check_int("0x10", true, 16);
+    check_int("0XfF", true, 255);
+    check_int("0xffffffff", true, -1);
+    check_int("-0x10", true, -16);
+    check_int("0x100000000", false);
+    check_int("0x", false);
+    check_int("", false);
+    check_int("   ", false);
+    check_int("-", false);
+    check_int("- 3", false);
+    check_int("12a", false);
+    check_int("0x1g", false);
+    check_int("abc", false);
+
+    // ranges leave the input alone when the value is outside
+    {
+        CommandArgs args("300 7");
+        int32_t value = 0;
+        CHECK(!args.next_int(&value, 0, 255), "300 accepted for 0-255");
+        CHECK(strcmp(args.rest(), "300 7") == 0, "range failure consumed '%s'", args.rest());
+        CHECK(args.next_int(&value, 0, 1000) && value == 300, "300 rejected for 0-1000");
+        CHECK(args.next_int(&value, 7, 7) && value == 7 && args.done(), "7 rejected for 7-7");
+    }
+
+    // words are truncated to the buffer but fully consumed
+    {
+        CommandArgs args("  hello world  ");
+        char buf[4];
+        CHECK(args.next_word(buf, sizeof(buf)) == 5 && strcmp(buf, "hel") == 0, "word '%s'", buf);
+        CHECK(strcmp(args.rest(), "world  ") == 0, "rest '%s'", args.rest());
+        CHECK(args.next_word(buf, sizeof(buf)) == 5 && strcmp(buf, "wor") == 0, "word '%s'", buf);
+        CHECK(args.done() && args.next_word(buf, sizeof(buf)) == 0 && buf[0] == '\0', "words after the end");
+    }
+
+    return check_result();
+}
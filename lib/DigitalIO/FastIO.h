@@ -0,0 +1,111 @@
+/*******************************************************************************
+ * FastIn/FastOut: DigitalIn/DigitalOut with the pin resolved at compile time
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+/*
+ * The Arduino pin number is a template parameter, so the port group and bit
+ * mask come from a constexpr copy of the variant pin table and write() is a
+ * single store to OUTSET or OUTCLR on the IOBUS (see wiring_digital.h), with
+ * no table lookup or pull-up check like digitalWrite(). Use these for pins touched from interrupts or tight
+ * loops, the API is otherwise the same as DigitalIn/DigitalOut.
+ *
+ *   FastOut<13> led(HIGH);
+ *   led = 0;
+ *   led.toggle();
+ *
+ * Unlike DigitalOut, writing a FastOut doesn't switch the pull-up on an input
+ * pin, and read() returns the OUT register rather than a cached value.
+ */
+
+#ifndef FASTIO_H
+#define FASTIO_H
+
+#include <stdint.h>
+#include "sam.h"
+#include "WVariant.h"
+#include "WInterrupts.h"
+#include "wiring_constants.h"
+#include "wiring_digital.h"
+
+struct FastPinInfo {
+    uint8_t port;
+    uint8_t pin;
+};
+
+static constexpr FastPinInfo fast_pin_table[] = {
+#define PIN(port, pin, ...) { port, pin },
+#include "variant_pins.inc"
+#undef PIN
+};
+
+static constexpr uint32_t FAST_PIN_COUNT = sizeof(fast_pin_table) / sizeof(fast_pin_table[0]);
+
+template<uint32_t Pin>
+class FastOut
+{
+    static_assert(Pin < FAST_PIN_COUNT, "FastOut pin number out of range");
+
+    public:
+        static constexpr uint32_t port = fast_pin_table[Pin].port;
+        static constexpr uint32_t mask = 1ul << fast_pin_table[Pin].pin;
+
+        FastOut(int value=0)
+        {
+            pinMode(Pin, OUTPUT);
+            write(value);
+        }
+
+        inline void write(int value)
+        {
+            if (value)
+                set();
+            else
+                clear();
+        }
+
+        inline void set(void)    { portOutSet(port, mask); }
+        inline void clear(void)  { portOutClear(port, mask); }
+        inline void toggle(void) { portOutToggle(port, mask); }
+
+        inline int read(void) const { return (portOutRead(port) & mask) != 0; }
+
+        inline FastOut& operator= (int value) { write(value); return *this; }
+        inline operator int() const { return read(); }
+};
+
+template<uint32_t Pin>
+class FastIn
+{
+    static_assert(Pin < FAST_PIN_COUNT, "FastIn pin number out of range");
+
+    public:
+        static constexpr uint32_t port = fast_pin_table[Pin].port;
+        static constexpr uint32_t mask = 1ul << fast_pin_table[Pin].pin;
+
+        FastIn(uint32_t _mode=INPUT) { mode(_mode); }
+
+        inline int read(void) const { return (portInRead(port) & mask) != 0; }
+        inline operator int() const { return read(); }
+
+        inline void mode(uint32_t _mode) { pinMode(Pin, _mode); }
+        inline void add_interrupt(voidFuncPtr isr, uint32_t _mode) { attachInterrupt(Pin, isr, _mode); }
+        inline void remove_interrupt(void) { detachInterrupt(Pin); }
+        inline void set_interrupt_filter(bool filter) { setInterruptFilter(Pin, filter); }
+};
+
+#endif // FASTIO_H
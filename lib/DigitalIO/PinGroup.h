@@ -0,0 +1,146 @@
+/*******************************************************************************
+ * PinGroup: read or write several pins of one port in a single access
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+/*
+ * The pins are Arduino pin numbers given as template parameters, and must all
+ * be on the same port, which is checked at compile time. read() and write()
+ * use a packed value where bit i is the i'th pin in the list, for example
+ *
+ *   PinGroup<7, 6> rpg(INPUT);
+ *   uint32_t state = rpg.read(); // (pin6 << 1) | pin7, from one read of IN
+ *
+ * The _raw() functions use the port's bit positions instead and skip the
+ * packing, which is only a shift when the pins are consecutive port bits in
+ * increasing order.
+ *
+ * Writes go through the IOBUS and reads through PORT, see wiring_digital.h.
+ * write() changes every pin in the group on the same clock cycle.
+ */
+
+#ifndef PINGROUP_H
+#define PINGROUP_H
+
+#include <stdint.h>
+#include "FastIO.h"
+
+// compile-time properties of a list of pins, used by PinGroup
+template<uint32_t... Pins>
+struct PinGroupInfo
+{
+    static constexpr uint32_t pins[] = { Pins... };
+    static constexpr uint32_t count = sizeof...(Pins);
+
+    static constexpr bool valid(void)
+    {
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (pins[i] >= FAST_PIN_COUNT ||
+                    fast_pin_table[pins[i]].port != fast_pin_table[pins[0]].port)
+                return false;
+        }
+        return true;
+    }
+
+    static constexpr uint32_t port_bit(uint32_t i)
+    {
+        return fast_pin_table[pins[i]].pin;
+    }
+
+    static constexpr uint32_t mask(void)
+    {
+        uint32_t m = 0;
+        for (uint32_t i = 0; i < count; i++)
+            m |= 1ul << port_bit(i);
+        return m;
+    }
+
+    static constexpr bool consecutive(void)
+    {
+        for (uint32_t i = 1; i < count; i++)
+            if (port_bit(i) != port_bit(0) + i)
+                return false;
+        return true;
+    }
+};
+
+template<uint32_t... Pins>
+constexpr uint32_t PinGroupInfo<Pins...>::pins[];
+
+template<uint32_t... Pins>
+class PinGroup
+{
+    typedef PinGroupInfo<Pins...> Info;
+    static_assert(Info::count > 0, "PinGroup needs at least one pin");
+    static_assert(Info::valid(), "PinGroup pins must all be valid and on the same port");
+
+    public:
+        static constexpr uint32_t port = fast_pin_table[Info::pins[0]].port;
+        static constexpr uint32_t mask = Info::mask();
+
+        // Don't configure the pins, e.g. when they're already set up by FastIn
+        // or another driver
+        PinGroup(void) {}
+
+        PinGroup(uint32_t _mode) { mode(_mode); }
+
+        void mode(uint32_t _mode)
+        {
+            for (uint32_t i = 0; i < Info::count; i++)
+                pinMode(Info::pins[i], _mode);
+        }
+
+        // port bits in mask to packed pin order and back
+        static inline uint32_t pack(uint32_t raw)
+        {
+            if (Info::consecutive())
+                return (raw & mask) >> Info::port_bit(0);
+
+            uint32_t value = 0;
+            for (uint32_t i = 0; i < Info::count; i++)
+                value |= ((raw >> Info::port_bit(i)) & 1) << i;
+            return value;
+        }
+
+        static inline uint32_t unpack(uint32_t value)
+        {
+            if (Info::consecutive())
+                return (value << Info::port_bit(0)) & mask;
+
+            uint32_t raw = 0;
+            for (uint32_t i = 0; i < Info::count; i++)
+                raw |= ((value >> i) & 1) << Info::port_bit(i);
+            return raw;
+        }
+
+        inline uint32_t read_raw(void) const { return portInRead(port) & mask; }
+        inline uint32_t read(void) const { return pack(portInRead(port)); }
+
+        inline void write_raw(uint32_t raw) { portOutWrite(port, mask, raw); }
+        inline void write(uint32_t value) { write_raw(unpack(value)); }
+
+        // set, clear, or toggle only the port bits in raw, a single store
+        inline void set_raw(uint32_t raw)    { portOutSet(port, raw & mask); }
+        inline void clear_raw(uint32_t raw)  { portOutClear(port, raw & mask); }
+        inline void toggle_raw(uint32_t raw) { portOutToggle(port, raw & mask); }
+
+        inline PinGroup& operator= (uint32_t value) { write(value); return *this; }
+        inline operator uint32_t() const { return read(); }
+};
+
+#endif // PINGROUP_H
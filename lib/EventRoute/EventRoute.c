@@ -0,0 +1,220 @@
+/*******************************************************************************
+ * Event System (EVSYS) channel allocation and routing
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include <sam.h>
+#include "EventRoute.h"
+#include "WVariant.h"
+
+static uint32_t channels_used = 0;
+
+// CHANNEL register value of each allocated channel, for software triggers,
+// and a bitmask of the users attached to it so disconnect can detach them
+// (USER can't be read back without a write first)
+static uint32_t channel_config[EVSYS_CHANNELS];
+static uint32_t channel_users[EVSYS_CHANNELS];
+
+static inline uint32_t irq_save(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    return primask;
+}
+
+static inline void irq_restore(uint32_t primask)
+{
+    __set_PRIMASK(primask);
+}
+
+static inline bool channel_valid(int channel)
+{
+    return channel >= 0 && channel < EVSYS_CHANNELS && (channels_used & (1ul << channel));
+}
+
+// USER.CHANNEL is the channel number plus one, 0 detaches the user
+static inline void set_user(uint8_t user, uint32_t channel_plus_one)
+{
+    EVSYS->USER.reg = (uint16_t)(EVSYS_USER_CHANNEL(channel_plus_one) | EVSYS_USER_USER(user));
+}
+
+int event_route_connect(uint8_t generator, uint8_t user, EventPath path, EventEdge edge)
+{
+    if (generator == EVENT_GEN_NONE || generator > EVSYS_GENERATORS || user >= EVSYS_USERS)
+        return -1;
+
+    // the asynchronous path has no edge detection, and the others need one
+    // to output anything
+    if ((path == EVENT_PATH_ASYNC) != (edge == EVENT_EDGE_NONE))
+        return -1;
+
+    uint32_t primask = irq_save();
+    int channel;
+    for (channel = 0; channel < EVSYS_CHANNELS; channel++)
+    {
+        if (!(channels_used & (1ul << channel)))
+            break;
+    }
+    if (channel == EVSYS_CHANNELS)
+    {
+        irq_restore(primask);
+        return -1;
+    }
+    channels_used |= 1ul << channel;
+    irq_restore(primask);
+
+    PM->APBCMASK.reg |= PM_APBCMASK_EVSYS;
+
+    // the synchronous and resynchronized paths run from the channel's GCLK
+    if (path != EVENT_PATH_ASYNC)
+    {
+        GCLK->CLKCTRL.reg = (uint16_t)(GCLK_CLKCTRL_CLKEN | GCLK_CLKCTRL_GEN_GCLK0 |
+                                       GCLK_CLKCTRL_ID(GCM_EVSYS_CHANNEL_0 + channel));
+        while (GCLK->STATUS.bit.SYNCBUSY);
+    }
+
+    // connect the user before the generator so no event is half-delivered
+    set_user(user, channel + 1);
+    channel_users[channel] = 1ul << user;
+
+    channel_config[channel] =
+        EVSYS_CHANNEL_CHANNEL(channel)  |
+        EVSYS_CHANNEL_EDGSEL(edge)      |
+        EVSYS_CHANNEL_PATH(path)        |
+        EVSYS_CHANNEL_EVGEN(generator);
+    EVSYS->CHANNEL.reg = channel_config[channel];
+
+    return channel;
+}
+
+int event_route_add_user(int channel, uint8_t user)
+{
+    if (!channel_valid(channel) || user >= EVSYS_USERS)
+        return -1;
+
+    set_user(user, channel + 1);
+    channel_users[channel] |= 1ul << user;
+    return 0;
+}
+
+void event_route_disconnect(int channel)
+{
+    if (!channel_valid(channel))
+        return;
+
+    // turn off the generator, then detach the users
+    EVSYS->CHANNEL.reg = EVSYS_CHANNEL_CHANNEL(channel);
+    for (uint8_t user = 0; user < EVSYS_USERS; user++)
+    {
+        if (channel_users[channel] & (1ul << user))
+            set_user(user, 0);
+    }
+
+    if ((channel_config[channel] & EVSYS_CHANNEL_PATH_Msk) !=
+            EVSYS_CHANNEL_PATH(EVENT_PATH_ASYNC))
+    {
+        GCLK->CLKCTRL.reg = (uint16_t)(GCLK_CLKCTRL_GEN_GCLK0 |
+                                       GCLK_CLKCTRL_ID(GCM_EVSYS_CHANNEL_0 + channel));
+        while (GCLK->STATUS.bit.SYNCBUSY);
+    }
+
+    channel_users[channel] = 0;
+    channel_config[channel] = 0;
+
+    uint32_t primask = irq_save();
+    channels_used &= ~(1ul << channel);
+    irq_restore(primask);
+}
+
+void event_route_trigger(int channel)
+{
+    if (channel_valid(channel))
+        EVSYS->CHANNEL.reg = channel_config[channel] | EVSYS_CHANNEL_SWEVT;
+}
+
+bool event_route_busy(int channel)
+{
+    if (!channel_valid(channel))
+        return false;
+
+    // channels 0-7 are in the low half of each byte pair, 8-11 in the high half
+    const uint32_t bit = (channel < 8) ? (8 + channel) : (24 + channel - 8);
+    return (EVSYS->CHSTATUS.reg & (1ul << bit)) != 0;
+}
+
+uint32_t event_route_channels_used(void)
+{
+    return channels_used;
+}
+
+uint8_t event_gen_tc_ovf(Tc *tc)
+{
+    if (tc == TC3) return EVSYS_ID_GEN_TC3_OVF;
+    if (tc == TC4) return EVSYS_ID_GEN_TC4_OVF;
+    if (tc == TC5) return EVSYS_ID_GEN_TC5_OVF;
+    return EVENT_GEN_NONE;
+}
+
+uint8_t event_gen_tc_mc(Tc *tc, unsigned int n)
+{
+    if (n > 1) return EVENT_GEN_NONE;
+    if (tc == TC3) return EVSYS_ID_GEN_TC3_MCX_0 + n;
+    if (tc == TC4) return EVSYS_ID_GEN_TC4_MCX_0 + n;
+    if (tc == TC5) return EVSYS_ID_GEN_TC5_MCX_0 + n;
+    return EVENT_GEN_NONE;
+}
+
+uint8_t event_gen_tcc_ovf(Tcc *tcc)
+{
+    if (tcc == TCC0) return EVSYS_ID_GEN_TCC0_OVF;
+    if (tcc == TCC1) return EVSYS_ID_GEN_TCC1_OVF;
+    if (tcc == TCC2) return EVSYS_ID_GEN_TCC2_OVF;
+    return EVENT_GEN_NONE;
+}
+
+uint8_t event_gen_tcc_mc(Tcc *tcc, unsigned int n)
+{
+    if (tcc == TCC0 && n < 4) return EVSYS_ID_GEN_TCC0_MCX_0 + n;
+    if (tcc == TCC1 && n < 2) return EVSYS_ID_GEN_TCC1_MCX_0 + n;
+    if (tcc == TCC2 && n < 2) return EVSYS_ID_GEN_TCC2_MCX_0 + n;
+    return EVENT_GEN_NONE;
+}
+
+uint8_t event_user_tc(Tc *tc)
+{
+    if (tc == TC3) return EVSYS_ID_USER_TC3_EVU;
+    if (tc == TC4) return EVSYS_ID_USER_TC4_EVU;
+    if (tc == TC5) return EVSYS_ID_USER_TC5_EVU;
+    return EVENT_USER_NONE;
+}
+
+uint8_t event_user_tcc_ev(Tcc *tcc, unsigned int n)
+{
+    if (n > 1) return EVENT_USER_NONE;
+    if (tcc == TCC0) return EVSYS_ID_USER_TCC0_EV_0 + n;
+    if (tcc == TCC1) return EVSYS_ID_USER_TCC1_EV_0 + n;
+    if (tcc == TCC2) return EVSYS_ID_USER_TCC2_EV_0 + n;
+    return EVENT_USER_NONE;
+}
+
+uint8_t event_user_tcc_mc(Tcc *tcc, unsigned int n)
+{
+    if (tcc == TCC0 && n < 4) return EVSYS_ID_USER_TCC0_MC_0 + n;
+    if (tcc == TCC1 && n < 2) return EVSYS_ID_USER_TCC1_MC_0 + n;
+    if (tcc == TCC2 && n < 2) return EVSYS_ID_USER_TCC2_MC_0 + n;
+    return EVENT_USER_NONE;
+}
@@ -0,0 +1,119 @@
+/*******************************************************************************
+ * Event System (EVSYS) channel allocation and routing
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+/*
+ * EVSYS connects a peripheral event output (generator) to one or more
+ * peripheral event inputs (users) with no CPU involvement. event_route_connect()
+ * takes a free channel out of the 12, so drivers don't need to agree on fixed
+ * channel numbers, and event_route_disconnect() detaches its users and
+ * frees it again.
+ *
+ * Generators and users are the EVSYS_ID_GEN_* and EVSYS_ID_USER_* numbers
+ * from the CMSIS headers, or the helpers below for peripherals picked at run
+ * time. For example a pin's EXTINT restarting TC5:
+ *
+ *   int extint = attachInterruptEvent(pin, LOW);
+ *   int ch = event_route_connect(event_gen_extint(extint), event_user_tc(TC5),
+ *                                EVENT_PATH_RESYNC, EVENT_EDGE_RISING);
+ *
+ * The user peripheral still has to enable its event input (e.g. TC EVCTRL.TCEI
+ * and EVACT), and the generator its event output.
+ *
+ * Paths:
+ *  ASYNC:  no clock, lowest latency, the user sees the generator's signal
+ *          directly. Edge detection isn't available so the edge must be
+ *          EVENT_EDGE_NONE, and the user must be able to handle
+ *          asynchronous events.
+ *  SYNC:   generator and user clocked by the same GCLK as the channel (GCLK0).
+ *  RESYNC: generator on a different clock, resynchronized to GCLK0. Two or
+ *          three GCLK0 cycles of latency.
+ * SYNC and RESYNC channels need an edge, and support event_route_trigger().
+ */
+
+#ifndef EVENTROUTE_H
+#define EVENTROUTE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sam.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    EVENT_PATH_SYNC     = EVSYS_CHANNEL_PATH_SYNCHRONOUS_Val,
+    EVENT_PATH_RESYNC   = EVSYS_CHANNEL_PATH_RESYNCHRONIZED_Val,
+    EVENT_PATH_ASYNC    = EVSYS_CHANNEL_PATH_ASYNCHRONOUS_Val,
+} EventPath;
+
+typedef enum {
+    EVENT_EDGE_NONE     = EVSYS_CHANNEL_EDGSEL_NO_EVT_OUTPUT_Val,
+    EVENT_EDGE_RISING   = EVSYS_CHANNEL_EDGSEL_RISING_EDGE_Val,
+    EVENT_EDGE_FALLING  = EVSYS_CHANNEL_EDGSEL_FALLING_EDGE_Val,
+    EVENT_EDGE_BOTH     = EVSYS_CHANNEL_EDGSEL_BOTH_EDGES_Val,
+} EventEdge;
+
+// Allocate a channel and route generator to user. Returns the channel
+// number, or -1 if none are free or the path and edge don't go together.
+int event_route_connect(uint8_t generator, uint8_t user, EventPath path, EventEdge edge);
+
+// Add another user to a connected channel. Returns 0, or -1 for a bad channel.
+int event_route_add_user(int channel, uint8_t user);
+
+// Detach every user from the channel, turn it off, and free it
+void event_route_disconnect(int channel);
+
+// Generate an event on a SYNC or RESYNC channel from software
+void event_route_trigger(int channel);
+
+// true if any user of a SYNC or RESYNC channel hasn't handled the last event
+bool event_route_busy(int channel);
+
+// bitmask of allocated channels
+uint32_t event_route_channels_used(void);
+
+// Generator and user IDs for peripherals picked at run time. An unknown
+// peripheral or index gives EVENT_GEN_NONE or EVENT_USER_NONE, which
+// event_route_connect() rejects. (User 0 is DMAC channel 0, so "none" is 0xff.)
+#define EVENT_GEN_NONE  0
+#define EVENT_USER_NONE 0xff
+
+static inline uint8_t event_gen_extint(uint32_t extint)
+{
+    return extint < 16 ? EVSYS_ID_GEN_EIC_EXTINT_0 + extint : EVENT_GEN_NONE;
+}
+uint8_t event_gen_tc_ovf(Tc *tc);
+uint8_t event_gen_tc_mc(Tc *tc, unsigned int n);
+uint8_t event_gen_tcc_ovf(Tcc *tcc);
+uint8_t event_gen_tcc_mc(Tcc *tcc, unsigned int n);
+
+uint8_t event_user_tc(Tc *tc);
+uint8_t event_user_tcc_ev(Tcc *tcc, unsigned int n);     // EV0/EV1 input, e.g. faults
+uint8_t event_user_tcc_mc(Tcc *tcc, unsigned int n);     // MCn capture input
+static inline uint8_t event_user_dmac(unsigned int ch)
+{
+    return ch < 4 ? EVSYS_ID_USER_DMAC_CH_0 + ch : EVENT_USER_NONE;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EVENTROUTE_H
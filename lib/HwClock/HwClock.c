@@ -0,0 +1,135 @@
+/*******************************************************************************
+ * SAMD21 HwClock library. Free-running 32/64-bit hardware timestamp counter
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include <sam.h>
+#include "HwClock.h"
+
+#ifndef F_CPU
+#include "variant.h"
+#endif
+
+#define HWCLOCK_GCLK_DIV (F_CPU / HWCLOCK_FREQ_HZ)
+
+#if (F_CPU % HWCLOCK_FREQ_HZ) != 0 || HWCLOCK_GCLK_DIV < 1 || HWCLOCK_GCLK_DIV > 255
+#error HWCLOCK_FREQ_HZ must divide F_CPU by an integer from 1 to 255
+#endif
+
+#if HWCLOCK_GCLK_GEN < 4 || HWCLOCK_GCLK_GEN > 8
+#error HWCLOCK_GCLK_GEN must be an unused generator from 4 to 8
+#endif
+
+// upper 32 bits of the count, incremented on every overflow
+static volatile uint32_t hwclock_hi = 0;
+
+void TC4_Handler(void)
+{
+    const uint8_t flags = TC4->COUNT32.INTFLAG.reg;
+
+    if (flags & TC_INTFLAG_OVF)
+    {
+        TC4->COUNT32.INTFLAG.reg = TC_INTFLAG_OVF;
+        hwclock_hi++;
+    }
+
+    if (flags & TC_INTFLAG_MC0)
+    {
+        // the alarm only needs to wake the CPU, disarm it
+        TC4->COUNT32.INTENCLR.reg = TC_INTENCLR_MC0;
+        TC4->COUNT32.INTFLAG.reg = TC_INTFLAG_MC0;
+    }
+}
+
+static inline void hwclock_sync(void)
+{
+    while (TC4->COUNT32.STATUS.bit.SYNCBUSY);
+}
+
+void hwclock_init(void)
+{
+    NVIC_DisableIRQ(TC4_IRQn);
+    NVIC_ClearPendingIRQ(TC4_IRQn);
+    NVIC_SetPriority(TC4_IRQn, 0);
+
+    PM->APBCMASK.reg |= PM_APBCMASK_TC4 | PM_APBCMASK_TC5;
+
+    // dedicated generator: DFLL48M / HWCLOCK_GCLK_DIV
+    GCLK->GENDIV.reg = GCLK_GENDIV_ID(HWCLOCK_GCLK_GEN) | GCLK_GENDIV_DIV(HWCLOCK_GCLK_DIV);
+    while (GCLK->STATUS.bit.SYNCBUSY);
+    GCLK->GENCTRL.reg = GCLK_GENCTRL_ID(HWCLOCK_GCLK_GEN) | GCLK_GENCTRL_SRC_DFLL48M | GCLK_GENCTRL_GENEN;
+    while (GCLK->STATUS.bit.SYNCBUSY);
+
+    GCLK->CLKCTRL.reg = (uint16_t)(GCLK_CLKCTRL_CLKEN | GCLK_CLKCTRL_GEN(HWCLOCK_GCLK_GEN) |
+                                   GCLK_CLKCTRL_ID(GCLK_CLKCTRL_ID_TC4_TC5_Val));
+    while (GCLK->STATUS.bit.SYNCBUSY);
+
+    // disable and reset
+    TC4->COUNT32.CTRLA.reg &= ~TC_CTRLA_ENABLE;
+    hwclock_sync();
+    TC4->COUNT32.CTRLA.reg = TC_CTRLA_SWRST;
+    hwclock_sync();
+    while (TC4->COUNT32.CTRLA.bit.SWRST);
+
+    // 32-bit mode (TC5 becomes the slave), normal frequency with TOP = 0xffffffff
+    TC4->COUNT32.CTRLA.reg =
+        TC_CTRLA_MODE(TC_CTRLA_MODE_COUNT32_Val)    |
+        TC_CTRLA_WAVEGEN(TC_CTRLA_WAVEGEN_NFRQ_Val) |
+        TC_CTRLA_PRESCALER(TC_CTRLA_PRESCALER_DIV1_Val);
+    hwclock_sync();
+
+    // keep COUNT continuously synchronized so reads don't need a READREQ
+    TC4->COUNT32.READREQ.reg = TC_READREQ_RCONT | TC_READREQ_ADDR(TC_COUNT32_COUNT_OFFSET);
+    hwclock_sync();
+
+    hwclock_hi = 0;
+    TC4->COUNT32.INTFLAG.reg = TC_INTFLAG_MASK;
+    TC4->COUNT32.INTENSET.reg = TC_INTENSET_OVF;
+
+    TC4->COUNT32.CTRLA.reg |= TC_CTRLA_ENABLE;
+    hwclock_sync();
+
+    NVIC_EnableIRQ(TC4_IRQn);
+}
+
+uint64_t hwclock_read64(void)
+{
+    // mask interrupts so the high word and overflow flag are consistent
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    const uint32_t hi = hwclock_hi;
+    const uint32_t lo = hwclock_read();
+    const int pending = TC4->COUNT32.INTFLAG.bit.OVF;
+
+    __set_PRIMASK(primask);
+    return hwclock_combine(hi, lo, pending);
+}
+
+void hwclock_set_alarm(uint32_t when)
+{
+    TC4->COUNT32.CC[0].reg = when;
+    hwclock_sync();
+    TC4->COUNT32.INTFLAG.reg = TC_INTFLAG_MC0;
+    TC4->COUNT32.INTENSET.reg = TC_INTENSET_MC0;
+}
+
+void hwclock_clear_alarm(void)
+{
+    TC4->COUNT32.INTENCLR.reg = TC_INTENCLR_MC0;
+    TC4->COUNT32.INTFLAG.reg = TC_INTFLAG_MC0;
+}
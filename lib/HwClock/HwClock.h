@@ -0,0 +1,90 @@
+/*******************************************************************************
+ * SAMD21 HwClock library. Free-running 32/64-bit hardware timestamp counter
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+/*
+ * TC4 and TC5 are chained in 32-bit mode, clocked by a dedicated generic clock
+ * generator dividing down the 48MHz DFLL. The count register is continuously
+ * synchronized (READREQ.RCONT) so that a timestamp is a single register read.
+ * The TC4 overflow interrupt extends the count to 64 bits.
+ *
+ * This uses TC4_Handler and makes TC5 unavailable, so HwClock can't be used
+ * together with Timeout, Tone, or a Timer on TC4 or TC5.
+ *
+ * Build with -DMICROS_USE_HWCLOCK (e.g. CPPFLAGS in the sketch config.mk) to
+ * make micros() and delay() use HwClock instead of SysTick. Adding -DDELAY_SLEEP
+ * makes delay() sleep with __WFI() until an HwClock alarm instead of spinning,
+ * and -DDELAY_SLEEP_SUPPRESS_SYSTICK also stops the 1ms SysTick interrupt
+ * during sleeps of 2ms or more.
+ */
+
+#ifndef HWCLOCK_H
+#define HWCLOCK_H
+
+#include <stdint.h>
+#include <sam.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Counter frequency. 48MHz must be an integer multiple of this, no more than
+// 255 times (the GCLK divider limit). MICROS_USE_HWCLOCK requires 1MHz.
+#ifndef HWCLOCK_FREQ_HZ
+#define HWCLOCK_FREQ_HZ 1000000ul
+#endif
+
+// Generic clock generator used to clock TC4/TC5. 0-3 are set up by startup.c
+#ifndef HWCLOCK_GCLK_GEN
+#define HWCLOCK_GCLK_GEN 4
+#endif
+
+void hwclock_init(void);
+
+// Current 32-bit count, a single register read
+static inline uint32_t hwclock_read(void)
+{
+    return TC4->COUNT32.COUNT.reg;
+}
+
+// Current 64-bit count, which won't wrap for 584000 years at 1MHz
+uint64_t hwclock_read64(void);
+
+// Raise the TC4 interrupt when the 32-bit count reaches when, e.g. to wake up
+// from __WFI(). The alarm is one-shot. Writing CC0 takes a few counts to
+// synchronize, so it can be missed if when is less than ~5us away.
+void hwclock_set_alarm(uint32_t when);
+void hwclock_clear_alarm(void);
+
+/*
+ * Combine the software high word with a low word read from the counter.
+ * If the overflow interrupt is pending but hasn't run yet, the high word is
+ * stale for low words that have already wrapped (small values), but not for a
+ * low word read just before the wrap (large values).
+ */
+static inline uint64_t hwclock_combine(uint32_t hi, uint32_t lo, int ovf_pending)
+{
+    if (ovf_pending && lo < 0x80000000ul)
+        hi++;
+    return ((uint64_t)hi << 32) | lo;
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif // HWCLOCK_H
@@ -0,0 +1,90 @@
+/*******************************************************************************
+ * Lock-free single-producer single-consumer event queue
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+/*
+ * A ring of N items with free-running head and tail counts, so all N slots
+ * are usable and count() is a subtraction. The producer only writes _head and
+ * the consumer only writes _tail, so one interrupt can push while the main
+ * loop pops without either masking interrupts. Items are copied in before
+ * _head moves and out before _tail moves, ordered by compiler barriers, which
+ * is all a single in-order core needs.
+ *
+ * More than one producer (or consumer) must be serialized by the caller,
+ * e.g. by masking interrupts around push(). No hardware dependencies.
+ */
+
+#ifndef EVENTQUEUE_H
+#define EVENTQUEUE_H
+
+#include <stdint.h>
+
+template<typename T, unsigned int N>
+class EventQueue
+{
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "EventQueue size must be a power of 2");
+
+    public:
+        EventQueue(void) : _head(0), _tail(0), _dropped(0) { }
+
+        // Producer side. Returns false and counts a drop if the queue is full.
+        bool push(const T &item)
+        {
+            const uint32_t head = _head;
+            if (head - _tail == N)
+            {
+                _dropped = _dropped + 1;
+                return false;
+            }
+            _items[head & (N - 1)] = item;
+            barrier();
+            _head = head + 1;
+            return true;
+        }
+
+        // Consumer side. Returns false if the queue is empty.
+        bool pop(T *item)
+        {
+            const uint32_t tail = _tail;
+            if (tail == _head)
+                return false;
+            barrier();
+            *item = _items[tail & (N - 1)];
+            barrier();
+            _tail = tail + 1;
+            return true;
+        }
+
+        // Consumer side, discard everything queued
+        inline void clear(void) { _tail = _head; }
+
+        inline uint32_t count(void) const { return _head - _tail; }
+        inline bool empty(void) const { return _head == _tail; }
+        inline uint32_t dropped(void) const { return _dropped; }
+        inline unsigned int size(void) const { return N; }
+
+    private:
+        T _items[N];
+        volatile uint32_t _head;
+        volatile uint32_t _tail;
+        volatile uint32_t _dropped;
+
+        static inline void barrier(void) { asm volatile("" ::: "memory"); }
+};
+
+#endif // EVENTQUEUE_H
@@ -0,0 +1,112 @@
+/*******************************************************************************
+ * Debounced, timestamped input events from buttons and encoders
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include "Arduino.h"
+#include "EventQueue.h"
+#include "InputEvents.h"
+
+static EventQueue<InputEvent, INPUT_EVENT_QUEUE_SIZE> queue;
+
+static InputNotifyFunc notify_func = NULL;
+static void *notify_ctx = NULL;
+
+bool input_event_push(InputEventType type, uint8_t id, int16_t value, uint32_t ticks)
+{
+    const InputEvent ev = { ticks, type, id, value };
+
+    // the queue is single-producer, serialize interrupts of different priorities
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    const bool ok = queue.push(ev);
+    __set_PRIMASK(primask);
+
+    if (ok && notify_func)
+        notify_func(notify_ctx);
+    return ok;
+}
+
+bool input_event_pop(InputEvent *ev)
+{
+    return queue.pop(ev);
+}
+
+uint32_t input_events_dropped(void)
+{
+    return queue.dropped();
+}
+
+void input_events_notify(InputNotifyFunc func, void *ctx)
+{
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    notify_func = func;
+    notify_ctx = ctx;
+    __set_PRIMASK(primask);
+}
+
+InputButton::InputButton(uint8_t id, uint32_t pin, bool active_low, uint32_t debounce_us) :
+    _settle_event(settle, this), _pin(pin), _debounce_us(debounce_us), _edge_ticks(0),
+    _id(id), _extint(0), _active_low(active_low), _pressed(false)
+{
+}
+
+void InputButton::begin(void)
+{
+    pinMode(_pin, _active_low ? INPUT_PULLUP : INPUT);
+    _extint = g_APinDescription[_pin].ulExtInt;
+    _pressed = read_pin();
+
+    attachInterruptArg(_pin, edge_isr, this, CHANGE);
+    setInterruptFilter(_pin, true);
+}
+
+// digitalReadFast() reads IN through PORT, so the settle sample is the
+// current level and not a stale IOBUS value
+bool InputButton::read_pin(void) const
+{
+    return digitalReadFast(_pin) != _active_low;
+}
+
+// First edge of a press, release, or noise pulse. Mask the line until the
+// pin has had time to settle.
+void InputButton::edge_isr(uint32_t extint, void *ctx)
+{
+    InputButton *b = static_cast<InputButton*>(ctx);
+    b->_edge_ticks = timer_service_ticks();
+    EIC->INTENCLR.reg = EIC_INTENCLR_EXTINT(1ul << extint);
+    timer_service_start(b->_settle_event, b->_debounce_us);
+}
+
+// Unmask before sampling the pin, so an edge after the sample isn't missed.
+// An edge between unmasking and the sample is harmless, its settle finds the
+// state unchanged.
+void InputButton::settle(void *ctx)
+{
+    InputButton *b = static_cast<InputButton*>(ctx);
+    const uint32_t mask = 1ul << b->_extint;
+    EIC->INTFLAG.reg = EIC_INTFLAG_EXTINT(mask);
+    EIC->INTENSET.reg = EIC_INTENSET_EXTINT(mask);
+
+    const bool pressed = b->read_pin();
+    if (pressed != b->_pressed)
+    {
+        b->_pressed = pressed;
+        input_event_push(pressed ? INPUT_PRESS : INPUT_RELEASE, b->_id, 0, b->_edge_ticks);
+    }
+}
@@ -0,0 +1,130 @@
+/*******************************************************************************
+ * Debounced, timestamped input events from buttons and encoders
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+/*
+ * Inputs push InputEvents from interrupts into one queue, and the main loop
+ * (or a Scheduler task) pops them in order with input_event_pop(). Nothing
+ * polls the pins.
+ *
+ * InputButton debounces in two stages. The EIC majority-vote filter rejects
+ * glitches shorter than a few GCLK cycles. The first edge that gets through
+ * records timer_service_ticks(), masks the EXTINT line, and starts a
+ * TimerService event. When that fires debounce_us later, the line is
+ * unmasked and the pin sampled. A press or release event is pushed only if
+ * the settled level differs from the last one reported, so bounces and short
+ * noise pulses produce nothing. The event's timestamp is the first edge, and
+ * the latency from that edge to the push is about debounce_us.
+ *
+ *   static InputButton button(0, 8);
+ *   ...
+ *   timer_service_init();
+ *   button.begin();
+ *   ...
+ *   InputEvent ev;
+ *   while (input_event_pop(&ev))
+ *       if (ev.type == INPUT_PRESS && ev.id == 0)
+ *           ...
+ *
+ * Buttons use attachInterruptArg() on their EXTINT line and TimerService on
+ * TC3. input_event_push() is safe to call from any interrupt, for other
+ * producers like encoders.
+ */
+
+#ifndef INPUTEVENTS_H
+#define INPUTEVENTS_H
+
+#include <stdint.h>
+#include "TimerService.h"
+
+// capacity of the event queue, a power of 2
+#ifndef INPUT_EVENT_QUEUE_SIZE
+#define INPUT_EVENT_QUEUE_SIZE 16
+#endif
+
+// default time a button must be stable before its new state is reported
+#ifndef INPUT_DEBOUNCE_US
+#define INPUT_DEBOUNCE_US 5000
+#endif
+
+enum InputEventType : uint8_t {
+    INPUT_PRESS,
+    INPUT_RELEASE,
+    INPUT_ROTATE,       // value is the signed number of steps
+};
+
+struct InputEvent {
+    uint32_t ticks;     // timer_service_ticks() at the input edge
+    InputEventType type;
+    uint8_t id;         // chosen by the input's owner
+    int16_t value;
+};
+
+typedef void (*InputNotifyFunc)(void *ctx);
+
+// Add an event to the queue. Returns false and counts a drop if it's full.
+// Safe from any interrupt priority.
+bool input_event_push(InputEventType type, uint8_t id, int16_t value, uint32_t ticks);
+
+// Remove the oldest event, false if there isn't one. Main loop only.
+bool input_event_pop(InputEvent *ev);
+
+// events lost to a full queue
+uint32_t input_events_dropped(void);
+
+// Time from an event's input edge to now in microseconds, to measure latency
+static inline uint32_t input_event_age_us(const InputEvent &ev)
+{
+    return (timer_service_ticks() - ev.ticks) / TIMER_SERVICE_TICKS_PER_US;
+}
+
+// Call func(ctx) from the interrupt after each push, e.g. to signal a
+// Scheduler Task waiting for input. NULL to disable.
+void input_events_notify(InputNotifyFunc func, void *ctx);
+
+class InputButton
+{
+    public:
+        // active_low buttons connect the pin to ground and use the internal
+        // pull-up, otherwise the pin is a plain input.
+        InputButton(uint8_t id, uint32_t pin, bool active_low=true,
+                    uint32_t debounce_us=INPUT_DEBOUNCE_US);
+
+        // Configure the pin and EIC line. Requires timer_service_init().
+        void begin(void);
+
+        // the debounced state
+        inline bool pressed(void) const { return _pressed; }
+        inline uint8_t id(void) const { return _id; }
+
+    private:
+        TimerEvent _settle_event;
+        uint32_t _pin;
+        uint32_t _debounce_us;
+        volatile uint32_t _edge_ticks;
+        uint8_t _id;
+        uint8_t _extint;
+        bool _active_low;
+        volatile bool _pressed;
+
+        bool read_pin(void) const;
+        static void edge_isr(uint32_t extint, void *ctx);
+        static void settle(void *ctx);
+};
+
+#endif // INPUTEVENTS_H
@@ -0,0 +1,137 @@
+/*
+ * eventqueue_test.cc: console application to check EventQueue ordering, full
+ * and empty handling, and index wraparound, then run a producer and consumer
+ * thread against each other.
+ * Extension is .cc instead of .cpp so that the samd21 Makefile ignores it.
+ *
+ * The threaded test relies on the host keeping stores in order (x86 does),
+ * like the single-core SAMD21 does for an interrupt and the main loop.
+ *
+ * Build and run:
+ *   g++ -O2 -Wall -Wextra -pthread -o eventqueue_test eventqueue_test.cc
+ *   ./eventqueue_test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <thread>
+
+#include "EventQueue.h"
+#include "../host_test.h"
+
+#define QUEUE_SIZE 16
+
+struct Item {
+    uint32_t seq;
+    uint32_t check;
+};
+
+static inline Item make_item(uint32_t seq)
+{
+    return Item{ seq, seq * 2654435761u };
+}
+
+// fill, overflow, and drain a few times, with random batch sizes so the
+// indices wrap at every offset
+static void test_sequential(void)
+{
+    EventQueue<Item, QUEUE_SIZE> q;
+    uint32_t pushed = 0, popped = 0, drops = 0;
+
+    CHECK(q.empty() && q.count() == 0, "new queue not empty");
+    Item it;
+    CHECK(!q.pop(&it), "pop from an empty queue succeeded");
+
+    for (int round = 0; round < 10000; round++)
+    {
+        const int npush = rand() % (QUEUE_SIZE + 4);
+        for (int i = 0; i < npush; i++)
+        {
+            const bool full = q.count() == QUEUE_SIZE;
+            const bool ok = q.push(make_item(pushed));
+            CHECK(ok == !full, "push returned %d with count %u", ok, q.count());
+            if (ok)
+                pushed++;
+            else
+                drops++;
+        }
+        CHECK(q.count() == pushed - popped, "count %u, expected %u", q.count(), pushed - popped);
+
+        const int npop = rand() % (QUEUE_SIZE + 4);
+        for (int i = 0; i < npop; i++)
+        {
+            const bool ok = q.pop(&it);
+            CHECK(ok == (pushed != popped), "pop returned %d with %u queued", ok, pushed - popped);
+            if (!ok)
+                break;
+            CHECK(it.seq == popped && it.check == make_item(popped).check,
+                  "popped seq %u, expected %u", it.seq, popped);
+            popped++;
+        }
+    }
+    CHECK(q.dropped() == drops, "dropped %u, expected %u", q.dropped(), drops);
+
+    q.clear();
+    CHECK(q.empty() && !q.pop(&it), "clear didn't empty the queue");
+    printf("sequential: %u pushed, %u popped, %u dropped\n", pushed, popped, drops);
+}
+
+// one thread pushes a numbered sequence, retrying when the queue is full, and
+// the other checks that it all comes out in order and intact
+static void test_threads(void)
+{
+    static EventQueue<Item, QUEUE_SIZE> q;
+    const uint32_t total = 2000000;
+    uint32_t full = 0;
+    std::atomic<bool> finished(false);
+
+    std::thread producer([&]() {
+        for (uint32_t seq = 0; seq < total; seq++)
+        {
+            while (!q.push(make_item(seq)))
+            {
+                full++;
+                std::this_thread::yield();
+            }
+        }
+        finished = true;
+    });
+
+    uint32_t received = 0;
+    while (true)
+    {
+        // read the flag before popping, so nothing pushed before it was set
+        // can be missed
+        const bool done = finished;
+        Item it;
+        if (q.pop(&it))
+        {
+            CHECK(it.check == make_item(it.seq).check, "corrupt item seq %u", it.seq);
+            CHECK(it.seq == received, "seq %u, expected %u", it.seq, received);
+            received++;
+        }
+        else if (done)
+        {
+            break;
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+
+    CHECK(received == total, "received %u of %u", received, total);
+    CHECK(q.dropped() == full, "dropped %u, push failed %u times", q.dropped(), full);
+    printf("threads: %u pushed, %u received, queue full %u times\n", total, received, full);
+}
+
+int main(void)
+{
+    srand(1);
+    test_sequential();
+    test_threads();
+
+    return check_result();
+}
@@ -0,0 +1,106 @@
+/*******************************************************************************
+ * Fixed-size PC sample counting table for the sampling profiler
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+/*
+ * An open-addressed hash table from PC to sample count. Inserting probes at
+ * most MAX_PROBES slots so the time spent in the sampling interrupt is
+ * bounded; samples that don't find a slot are counted in dropped().
+ *
+ * No hardware dependencies, the caller has to serialize access. See
+ * Profiler.h for the interrupt-driven instance.
+ */
+
+#ifndef PROFILETABLE_H
+#define PROFILETABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+template<unsigned int N>
+class ProfileTable
+{
+    static_assert(N >= 16 && (N & (N - 1)) == 0, "ProfileTable size must be a power of 2");
+
+    public:
+        struct Entry {
+            uint32_t pc;        // 0 for an unused slot
+            uint32_t count;
+        };
+
+        static constexpr unsigned int MAX_PROBES = 8;
+
+        ProfileTable(void) { clear(); }
+
+        void clear(void)
+        {
+            for (unsigned int i = 0; i < N; i++)
+                _entries[i].pc = _entries[i].count = 0;
+            _samples = 0;
+            _dropped = 0;
+        }
+
+        void add(uint32_t pc)
+        {
+            _samples++;
+            unsigned int i = hash(pc);
+            for (unsigned int probe = 0; probe < MAX_PROBES; probe++)
+            {
+                Entry &e = _entries[i];
+                if (e.pc == pc)
+                {
+                    e.count++;
+                    return;
+                }
+                if (e.pc == 0)
+                {
+                    e.pc = pc;
+                    e.count = 1;
+                    return;
+                }
+                i = (i + 1) & (N - 1);
+            }
+            _dropped++;
+        }
+
+        // total samples added, including dropped ones
+        inline uint32_t samples(void) const { return _samples; }
+        inline uint32_t dropped(void) const { return _dropped; }
+
+        inline unsigned int size(void) const { return N; }
+        inline const Entry &entry(unsigned int i) const { return _entries[i]; }
+
+    private:
+        Entry _entries[N];
+        uint32_t _samples;
+        uint32_t _dropped;
+
+        // Fibonacci hash of the halfword address, using the top bits of the
+        // product. Thumb instructions are 2-byte aligned.
+        static inline unsigned int hash(uint32_t pc)
+        {
+            return ((pc >> 1) * 2654435761u) >> (32 - log2(N));
+        }
+
+        static constexpr unsigned int log2(unsigned int n)
+        {
+            return n <= 1 ? 0 : 1 + log2(n >> 1);
+        }
+};
+
+#endif // PROFILETABLE_H
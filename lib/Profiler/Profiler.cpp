@@ -0,0 +1,131 @@
+/*******************************************************************************
+ * Statistical PC-sampling profiler
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include "Arduino.h"
+#include "Profiler.h"
+#include "ProfileTable.h"
+
+static ProfileTable<PROFILER_TABLE_SIZE> table;
+static uint32_t profiler_hz = 0;
+static bool running = false;
+
+static inline void sync(uint32_t mask) { while (TCC2->SYNCBUSY.reg & mask); }
+
+// Called from TCC2_Handler with the interrupted PC. The only reference is
+// inside the asm string, which LTO can't see, so keep the symbol and its name.
+extern "C" __attribute__((used, externally_visible)) void profiler_sample(uint32_t pc)
+{
+    TCC2->INTFLAG.reg = TCC_INTFLAG_OVF;
+    table.add(pc);
+}
+
+/*
+ * The stacked PC is 24 bytes into the exception frame (r0-r3, r12, lr, pc,
+ * xpsr), which is on the PSP or MSP depending on bit 2 of the EXC_RETURN
+ * value in lr. Nothing is pushed here, so sp is still the frame, and the tail
+ * call leaves lr alone so profiler_sample returns from the exception.
+ */
+extern "C" __attribute__((naked)) void TCC2_Handler(void)
+{
+    asm volatile(
+        "movs   r0, #4              \n"
+        "mov    r1, lr              \n"
+        "tst    r0, r1              \n"
+        "beq    1f                  \n"
+        "mrs    r0, psp             \n"
+        "b      2f                  \n"
+        "1:                         \n"
+        "mrs    r0, msp             \n"
+        "2:                         \n"
+        "ldr    r0, [r0, #24]       \n"
+        "ldr    r1, =profiler_sample\n"
+        "bx     r1                  \n"
+        ".ltorg                     \n"
+    );
+}
+
+bool profiler_start(uint32_t hz)
+{
+    if (hz < PROFILER_MIN_HZ || hz > PROFILER_MAX_HZ)
+        return false;
+
+    profiler_stop();
+
+    GCLK->CLKCTRL.reg = (uint16_t)(GCLK_CLKCTRL_CLKEN | GCLK_CLKCTRL_GEN_GCLK0 |
+                                   GCLK_CLKCTRL_ID(GCLK_CLKCTRL_ID_TCC2_TC3_Val));
+    while (GCLK->STATUS.bit.SYNCBUSY);
+
+    TCC2->CTRLA.reg = TCC_CTRLA_SWRST;
+    sync(TCC_SYNCBUSY_SWRST);
+
+    TCC2->CTRLA.reg = TCC_CTRLA_PRESCALER_DIV16;
+    TCC2->WAVE.reg = TCC_WAVE_WAVEGEN_NFRQ;
+    sync(TCC_SYNCBUSY_WAVE);
+    TCC2->PER.reg = (PROFILER_TICKS_PER_SEC + hz / 2) / hz - 1;
+    sync(TCC_SYNCBUSY_PER);
+
+    TCC2->INTENSET.reg = TCC_INTENSET_OVF;
+    NVIC_ClearPendingIRQ(TCC2_IRQn);
+    NVIC_SetPriority(TCC2_IRQn, 0);
+    NVIC_EnableIRQ(TCC2_IRQn);
+
+    TCC2->CTRLA.reg |= TCC_CTRLA_ENABLE;
+    sync(TCC_SYNCBUSY_ENABLE);
+
+    profiler_hz = hz;
+    running = true;
+    return true;
+}
+
+void profiler_stop(void)
+{
+    if (!running)
+        return;
+
+    TCC2->CTRLA.reg &= ~TCC_CTRLA_ENABLE;
+    sync(TCC_SYNCBUSY_ENABLE);
+    NVIC_DisableIRQ(TCC2_IRQn);
+    running = false;
+}
+
+bool profiler_running(void)
+{
+    return running;
+}
+
+void profiler_dump(Print &out, bool clear)
+{
+    NVIC_DisableIRQ(TCC2_IRQn);
+
+    out.printf("# profile hz=%u samples=%u dropped=%u\r\n"_fmt,
+               (unsigned)profiler_hz, (unsigned)table.samples(), (unsigned)table.dropped());
+    for (unsigned int i = 0; i < table.size(); i++)
+    {
+        const auto &e = table.entry(i);
+        if (e.pc != 0)
+            out.printf("%08x %u\r\n"_fmt, (unsigned)e.pc, (unsigned)e.count);
+    }
+    out.print("# end\r\n");
+
+    if (clear)
+        table.clear();
+
+    if (running)
+        NVIC_EnableIRQ(TCC2_IRQn);
+}
@@ -0,0 +1,72 @@
+/*******************************************************************************
+ * Statistical PC-sampling profiler
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+/*
+ * TCC2 interrupts at a fixed rate with the highest NVIC priority, and its
+ * handler counts the PC that was interrupted (read from the exception stack
+ * frame) in a hash table. Functions that show up in more samples use more CPU
+ * time. Idle time shows up as the WFI in delay() or wherever the CPU sleeps.
+ *
+ * Interrupts at the same priority (TC and EIC handlers use 0 too) and code
+ * with interrupts disabled can't be sampled, their time is attributed to
+ * wherever the CPU goes next.
+ *
+ *   profiler_start(2000);
+ *   ...
+ *   profiler_dump(SerialUSB);
+ *
+ * then on the host:
+ *   scripts/profile-report.py obj/<sketch>/<sketch>.elf capture.txt
+ *
+ * This takes over TCC2, so analogWrite() can't be used on TCC2 pins. TCC2
+ * shares its GCLK with TC3, both run from GCLK0 (as in TimerService).
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+#include "Print.h"
+
+// number of distinct PCs which can be counted, must be a power of 2. Each
+// entry is 8 bytes.
+#ifndef PROFILER_TABLE_SIZE
+#define PROFILER_TABLE_SIZE 256
+#endif
+
+// TCC2 counts GCLK0/16, 3 MHz. Its period is 16 bits.
+#define PROFILER_TICKS_PER_SEC  (VARIANT_MCK / 16)
+#define PROFILER_MIN_HZ         (PROFILER_TICKS_PER_SEC / 65536 + 1)
+#define PROFILER_MAX_HZ         50000
+
+// Start sampling at hz, which should be coprime with any periodic activity
+// being measured so samples don't alias. Returns false if hz is out of range.
+// Restarting keeps the samples collected so far.
+bool profiler_start(uint32_t hz=1999);
+void profiler_stop(void);
+bool profiler_running(void);
+
+// Print the sample counts and optionally clear them. Sampling is paused while
+// printing. The output is line based:
+//   # profile hz=<hz> samples=<n> dropped=<n>
+//   <pc hex> <count>               for each PC sampled
+//   # end
+void profiler_dump(Print &out, bool clear=true);
+
+#endif // PROFILER_H
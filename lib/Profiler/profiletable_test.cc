@@ -0,0 +1,141 @@
+/*
+ * profiletable_test.cc: console application to check ProfileTable sample
+ * aggregation against a reference std::map.
+ * Extension is .cc instead of .cpp so that the samd21 Makefile ignores it.
+ *
+ * Samples are drawn from a skewed distribution over thumb-aligned flash
+ * addresses, like a real profile where a few loops take most of the time.
+ * Every sample must be either counted exactly once or reported as dropped.
+ *
+ * Build and run:
+ *   g++ -O2 -Wall -Wextra -o profiletable_test profiletable_test.cc
+ *   ./profiletable_test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <map>
+
+#include "ProfileTable.h"
+#include "../host_test.h"
+
+#define TABLE_SIZE 256
+
+static ProfileTable<TABLE_SIZE> table;
+
+// Compare the table to the reference counts. With allow_drops false, every
+// reference PC must be in the table with its exact count.
+static void check_table(const std::map<uint32_t, uint32_t> &ref, uint32_t nsamples, bool allow_drops)
+{
+    CHECK(table.samples() == nsamples, "samples %u, expected %u", table.samples(), nsamples);
+
+    uint64_t counted = 0;
+    unsigned int used = 0;
+    for (unsigned int i = 0; i < table.size(); i++)
+    {
+        const auto &e = table.entry(i);
+        if (e.pc == 0)
+        {
+            CHECK(e.count == 0, "empty slot %u has count %u", i, e.count);
+            continue;
+        }
+        used++;
+        counted += e.count;
+
+        auto it = ref.find(e.pc);
+        CHECK(it != ref.end(), "pc 0x%08x was never sampled", e.pc);
+        if (it == ref.end())
+            continue;
+        CHECK(e.count <= it->second, "pc 0x%08x count %u, only %u samples", e.pc, e.count, it->second);
+        if (!allow_drops)
+            CHECK(e.count == it->second, "pc 0x%08x count %u, expected %u", e.pc, e.count, it->second);
+    }
+
+    // each PC has at most one slot
+    for (unsigned int i = 0; i < table.size(); i++)
+        for (unsigned int j = i + 1; j < table.size(); j++)
+            CHECK(table.entry(i).pc == 0 || table.entry(i).pc != table.entry(j).pc,
+                  "pc 0x%08x in slots %u and %u", table.entry(i).pc, i, j);
+
+    CHECK(counted + table.dropped() == nsamples, "counted %llu + dropped %u != %u samples",
+          (unsigned long long)counted, table.dropped(), nsamples);
+    if (!allow_drops)
+    {
+        CHECK(table.dropped() == 0, "%u samples dropped", table.dropped());
+        CHECK(used == ref.size(), "%u slots used, expected %zu", used, ref.size());
+    }
+}
+
+// A hot loop of consecutive instructions, the common case, must not collide
+// enough to drop samples
+static void test_hot_loop(void)
+{
+    std::map<uint32_t, uint32_t> ref;
+    table.clear();
+
+    uint32_t n = 0;
+    for (int rep = 0; rep < 1000; rep++)
+    {
+        for (uint32_t pc = 0x2400; pc < 0x2400 + 2 * (TABLE_SIZE / 2); pc += 2)
+        {
+            table.add(pc);
+            ref[pc]++;
+            n++;
+        }
+    }
+    check_table(ref, n, false);
+    printf("hot loop: %u samples, %zu PCs, %u dropped\n", n, ref.size(), table.dropped());
+}
+
+// Skewed random PCs, fewer distinct PCs than slots but enough collisions to
+// exercise probing. Some may still be dropped past MAX_PROBES.
+static void test_random(void)
+{
+    std::map<uint32_t, uint32_t> ref;
+    table.clear();
+
+    const uint32_t nsamples = 200000;
+    for (uint32_t n = 0; n < nsamples; n++)
+    {
+        // squaring a uniform value concentrates samples at low addresses
+        const uint32_t r = rand() % 4096;
+        const uint32_t pc = 0x2000 + 2 * ((r * r) >> 17);
+        table.add(pc);
+        ref[pc]++;
+    }
+    check_table(ref, nsamples, true);
+    printf("random: %u samples, %zu PCs, %u dropped\n", nsamples, ref.size(), table.dropped());
+}
+
+// Many more distinct PCs than slots, the table fills up and drops the rest
+static void test_overflow(void)
+{
+    std::map<uint32_t, uint32_t> ref;
+    table.clear();
+
+    const uint32_t nsamples = 200000;
+    for (uint32_t n = 0; n < nsamples; n++)
+    {
+        const uint32_t pc = 0x2000 + 2 * (rand() % 16384);
+        table.add(pc);
+        ref[pc]++;
+    }
+    check_table(ref, nsamples, true);
+    CHECK(table.dropped() > 0, "full table didn't drop samples");
+    printf("overflow: %u samples, %zu PCs, %u dropped\n", nsamples, ref.size(), table.dropped());
+
+    table.clear();
+    CHECK(table.samples() == 0 && table.dropped() == 0, "clear didn't reset the counts");
+    for (unsigned int i = 0; i < table.size(); i++)
+        CHECK(table.entry(i).pc == 0, "slot %u not cleared", i);
+}
+
+int main(void)
+{
+    srand(1);
+    test_hot_loop();
+    test_random();
+    test_overflow();
+
+    return check_result();
+}
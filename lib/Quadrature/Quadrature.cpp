@@ -0,0 +1,124 @@
+/*******************************************************************************
+ * Interrupt-driven quadrature decoder for rotary encoders
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include "Arduino.h"
+#include "Quadrature.h"
+
+Quadrature::Quadrature(uint32_t pin_a, uint32_t pin_b, uint32_t mode) :
+    _pin_a(pin_a), _pin_b(pin_b), _mode(mode), _port(0), _bit_a(0), _bit_b(0),
+    _velocity(false), _count(0), _delta_count(0), _step_us(0), _period_us(0), _direction(0)
+{
+}
+
+bool Quadrature::begin(bool filter)
+{
+    const PinDescription &a = g_APinDescription[_pin_a];
+    const PinDescription &b = g_APinDescription[_pin_b];
+    if (a.ulPort != b.ulPort ||
+            a.ulExtInt == NOT_AN_INTERRUPT || a.ulExtInt == EXTERNAL_INT_NMI ||
+            b.ulExtInt == NOT_AN_INTERRUPT || b.ulExtInt == EXTERNAL_INT_NMI)
+        return false;
+
+    _port = a.ulPort;
+    _bit_a = a.ulPin;
+    _bit_b = b.ulPin;
+
+    pinMode(_pin_a, _mode);
+    pinMode(_pin_b, _mode);
+
+    _decoder.reset(read_state());
+    _count = 0;
+    _delta_count = 0;
+
+    attachInterruptArg(_pin_a, edge_isr, this, CHANGE);
+    attachInterruptArg(_pin_b, edge_isr, this, CHANGE);
+    setInterruptFilter(_pin_a, filter);
+    setInterruptFilter(_pin_b, filter);
+    return true;
+}
+
+void Quadrature::end(void)
+{
+    detachInterrupt(_pin_a);
+    detachInterrupt(_pin_b);
+}
+
+int32_t Quadrature::delta(void)
+{
+    const int32_t count = _count;
+    const int32_t d = count - _delta_count;
+    _delta_count = count;
+    return d;
+}
+
+void Quadrature::enable_velocity(bool enable)
+{
+    _period_us = 0;
+    _direction = 0;
+    _velocity = enable;
+}
+
+int32_t Quadrature::velocity(void) const
+{
+    if (!_velocity)
+        return 0;
+
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    const uint32_t step_us = _step_us;
+    uint32_t period = _period_us;
+    const int8_t direction = _direction;
+    __set_PRIMASK(primask);
+
+    // slowing down shows up as the time since the last step growing past the
+    // last period, before the next step arrives
+    const uint32_t since = micros() - step_us;
+    if (period == 0 || since >= QUADRATURE_IDLE_US)
+        return 0;
+    if (since > period)
+        period = since;
+    return direction * (int32_t)(1000000ul / period);
+}
+
+inline uint8_t Quadrature::read_state(void) const
+{
+    // through PORT, so it's the resynchronized level after the edge
+    const uint32_t in = portInRead(_port);
+    return (((in >> _bit_a) & 1) << 1) | ((in >> _bit_b) & 1);
+}
+
+void Quadrature::edge_isr(uint32_t extint, void *ctx)
+{
+    (void)extint;
+    Quadrature *q = static_cast<Quadrature*>(ctx);
+
+    const int step = q->_decoder.step(q->read_state());
+    if (step == 0)
+        return;
+    q->_count = q->_count + step;
+
+    if (q->_velocity)
+    {
+        const uint32_t now = micros();
+        // a reversal restarts the estimate
+        q->_period_us = (step == q->_direction) ? now - q->_step_us : 0;
+        q->_step_us = now;
+        q->_direction = step;
+    }
+}
@@ -0,0 +1,102 @@
+/*******************************************************************************
+ * Interrupt-driven quadrature decoder for rotary encoders
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+/*
+ * Both channels interrupt on CHANGE, and the handler reads A and B together
+ * with one read of the port's IN register, so it always sees a consistent
+ * state even if the other channel moved since the edge. The read goes through
+ * PORT, an IOBUS read of IN could return the state from before the edge.
+ * QuadratureDecoder turns the state change into a step, which is added to a
+ * 32-bit count. Only the interrupt writes the count and 32-bit loads are
+ * atomic, so reading it never masks interrupts.
+ *
+ * Every edge is one count, so a typical detented encoder moves 4 counts per
+ * detent. The A and B pins must be on the same port and have EXTINT lines.
+ *
+ *   static Quadrature knob(6, 7);
+ *   ...
+ *   knob.begin();
+ *   ...
+ *   brightness += knob.delta();
+ *
+ * With enable_velocity(true), the handler also times the interval between
+ * steps with micros(), and velocity() estimates steps per second.
+ */
+
+#ifndef QUADRATURE_H
+#define QUADRATURE_H
+
+#include <stdint.h>
+#include "wiring_constants.h"
+#include "QuadratureDecoder.h"
+
+// velocity() is 0 after this long without a step
+#ifndef QUADRATURE_IDLE_US
+#define QUADRATURE_IDLE_US 200000
+#endif
+
+class Quadrature
+{
+    public:
+        // mode is the pinMode for both pins, usually INPUT_PULLUP for an
+        // encoder with common ground
+        Quadrature(uint32_t pin_a, uint32_t pin_b, uint32_t mode=INPUT_PULLUP);
+
+        // Configure the pins and interrupts. Returns false if the pins aren't
+        // on the same port or either has no EXTINT.
+        bool begin(bool filter=true);
+        void end(void);
+
+        // total count since begin()
+        inline int32_t count(void) const { return _count; }
+
+        // count change since the previous delta() call, main loop only
+        int32_t delta(void);
+
+        // transitions where both channels changed and a step was lost
+        inline uint32_t errors(void) const { return _decoder.errors(); }
+
+        void enable_velocity(bool enable);
+
+        // signed steps per second, 0 if velocity isn't enabled
+        int32_t velocity(void) const;
+
+    private:
+        QuadratureDecoder _decoder;
+        uint32_t _pin_a;
+        uint32_t _pin_b;
+        uint32_t _mode;
+        uint8_t _port;
+        uint8_t _bit_a;
+        uint8_t _bit_b;
+        volatile bool _velocity;
+
+        volatile int32_t _count;
+        int32_t _delta_count;
+
+        // for velocity(), written only by the interrupt
+        volatile uint32_t _step_us;
+        volatile uint32_t _period_us;
+        volatile int8_t _direction;
+
+        inline uint8_t read_state(void) const;
+        static void edge_isr(uint32_t extint, void *ctx);
+};
+
+#endif // QUADRATURE_H
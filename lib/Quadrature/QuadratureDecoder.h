@@ -0,0 +1,76 @@
+/*******************************************************************************
+ * Quadrature state machine for rotary encoders
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+/*
+ * States are (A << 1) | B. Forward rotation is the Gray sequence
+ * 00 -> 01 -> 11 -> 10 -> 00, so every valid transition changes one bit and
+ * the previous and current state index a 16-entry table of -1, 0, or +1.
+ * Contact bounce on one channel steps back and forth and cancels out.
+ *
+ * A transition that changes both bits means a state was missed, the
+ * direction is unknown, so it counts as 0 and is added to errors().
+ *
+ * No hardware dependencies, see Quadrature.h for the EIC-driven decoder.
+ */
+
+#ifndef QUADRATUREDECODER_H
+#define QUADRATUREDECODER_H
+
+#include <stdint.h>
+
+class QuadratureDecoder
+{
+    public:
+        QuadratureDecoder(uint8_t state=0) : _state(state & 3), _errors(0) { }
+
+        inline void reset(uint8_t state)
+        {
+            _state = state & 3;
+            _errors = 0;
+        }
+
+        // Move to a new A/B state, return the step taken
+        inline int step(uint8_t state)
+        {
+            // indexed by (previous state << 2) | current state
+            static const int8_t table[16] = {
+            //  00  01  10  11   <- current
+                 0, +1, -1,  0, // 00 previous
+                -1,  0,  0, +1, // 01
+                +1,  0,  0, -1, // 10
+                 0, -1, +1,  0, // 11
+            };
+
+            state &= 3;
+            const uint8_t prev = _state;
+            _state = state;
+            if ((prev ^ state) == 3)
+                _errors++;
+            return table[(prev << 2) | state];
+        }
+
+        inline uint8_t state(void) const { return _state; }
+        inline uint32_t errors(void) const { return _errors; }
+
+    private:
+        uint8_t _state;
+        uint32_t _errors;
+};
+
+#endif // QUADRATUREDECODER_H
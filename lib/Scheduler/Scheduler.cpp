@@ -0,0 +1,154 @@
+/*******************************************************************************
+ * Cooperative scheduler for stackless tasks
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include "Arduino.h"
+#include "Scheduler.h"
+
+static Task *task_list = NULL;
+static Task *task_tail = NULL;
+static bool scheduler_running = false;
+
+void Task::signal(uint32_t flags)
+{
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    _flags |= flags;
+    __set_PRIMASK(primask);
+}
+
+uint32_t Task::take(uint32_t mask)
+{
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    const uint32_t flags = _flags & mask;
+    _flags &= ~mask;
+    __set_PRIMASK(primask);
+    return flags;
+}
+
+void Task::restart(void)
+{
+    _lc = 0;
+    _wait_mask = 0;
+    _sleeping = false;
+    _done = false;
+}
+
+void Task::_sleep_us(uint32_t us)
+{
+    _wake_us = micros() + us;
+    _sleeping = true;
+}
+
+bool Task::ready(uint32_t now) const
+{
+    if (_done)
+        return false;
+    if (_wait_mask && (_flags & _wait_mask))
+        return true;
+    if (_sleeping)
+        return (int32_t)(now - _wake_us) >= 0;
+    return _wait_mask == 0;
+}
+
+void scheduler_add(Task &task)
+{
+    task._next = NULL;
+    if (task_tail != NULL)
+        task_tail->_next = &task;
+    else
+        task_list = &task;
+    task_tail = &task;
+}
+
+unsigned int scheduler_run(void)
+{
+    if (scheduler_running)
+        return 0;
+    scheduler_running = true;
+
+    unsigned int count = 0;
+    uint32_t now = micros();
+    for (Task *t = task_list; t != NULL; t = t->_next)
+    {
+        if (!t->ready(now))
+            continue;
+
+        t->_sleeping = false;
+        t->_wait_mask = 0;
+        const TaskState state = t->_func(*t);
+        if (state == TASK_DONE)
+            t->_done = true;
+
+        const uint32_t end = micros();
+        t->_runtime_us += end - now;
+        t->_runs++;
+        now = end;
+        count++;
+    }
+
+    scheduler_running = false;
+    return count;
+}
+
+// Runs with interrupts masked from delay(), so only reads state and micros()
+bool scheduler_next_wake(uint32_t *wake_us)
+{
+    const uint32_t now = micros();
+    bool found = false;
+    uint32_t wake = 0;
+
+    for (Task *t = task_list; t != NULL; t = t->_next)
+    {
+        if (t->ready(now))
+        {
+            *wake_us = now;
+            return true;
+        }
+        if (t->_done || !t->_sleeping)
+            continue;
+        if (!found || (int32_t)(t->_wake_us - wake) < 0)
+        {
+            wake = t->_wake_us;
+            found = true;
+        }
+    }
+
+    if (found)
+        *wake_us = wake;
+    return found;
+}
+
+void scheduler_print_stats(Print &out)
+{
+    out.printf("%-12s %10s %12s\r\n"_fmt, "task", "runs", "runtime_us");
+    for (Task *t = task_list; t != NULL; t = t->_next)
+        out.printf("%-12s %10u %12u\r\n"_fmt, t->_name, (unsigned)t->_runs, (unsigned)t->_runtime_us);
+}
+
+// Replace the weak hooks in hooks.c, so delay() runs tasks while it waits
+void yield(void)
+{
+    scheduler_run();
+}
+
+int yieldNextWake(uint32_t *us)
+{
+    return scheduler_next_wake(us);
+}
@@ -0,0 +1,158 @@
+/*******************************************************************************
+ * Cooperative scheduler for stackless tasks
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+/*
+ * Tasks are protothread-style functions: the TASK_* macros save the line
+ * number in the Task and return, and the next call jumps back there through a
+ * switch statement. There's no per-task stack, so local variables don't keep
+ * their values across a TASK_* wait. Keep state in statics or the task context,
+ * and don't use TASK_* macros inside another switch statement.
+ *
+ *   static TaskState blink(Task &t)
+ *   {
+ *       TASK_BEGIN(t);
+ *       while (true)
+ *       {
+ *           led = !led;
+ *           TASK_SLEEP_MS(t, 500);
+ *       }
+ *       TASK_END(t);
+ *   }
+ *   static Task blink_task(blink, "blink");
+ *   ...
+ *   scheduler_add(blink_task);
+ *
+ * Including this library replaces the empty yield() hook, so tasks run while
+ * delay() waits (and sleeps until the next task wake time with DELAY_SLEEP),
+ * or loop() can call scheduler_run() directly.
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Print.h"
+
+enum TaskState : uint8_t {
+    TASK_READY,         // run again on the next pass
+    TASK_WAITING,       // sleeping or waiting for flags
+    TASK_DONE,          // finished, won't run again until restart()
+};
+
+class Task;
+typedef TaskState (*TaskFunc)(Task &task);
+
+class Task
+{
+    public:
+        Task(TaskFunc func, const char *name, void *ctx=NULL) :
+            _lc(0), _func(func), _name(name), _ctx(ctx), _next(NULL), _flags(0),
+            _wait_mask(0), _wake_us(0), _sleeping(false), _done(false),
+            _runtime_us(0), _runs(0) { }
+
+        // Set event flags, which wakes the task if it's waiting for any of
+        // them. Safe to call from interrupts.
+        void signal(uint32_t flags);
+
+        // Clear and return the flags in mask
+        uint32_t take(uint32_t mask);
+
+        // Start over from TASK_BEGIN
+        void restart(void);
+
+        inline void *ctx(void) const { return _ctx; }
+        inline const char *name(void) const { return _name; }
+        inline bool done(void) const { return _done; }
+
+        // total time spent running and number of times run
+        inline uint32_t runtime_us(void) const { return _runtime_us; }
+        inline uint32_t runs(void) const { return _runs; }
+
+        // used by the TASK_* macros
+        uint16_t _lc;
+        void _sleep_us(uint32_t us);
+        inline void _wait_flags(uint32_t mask) { _wait_mask = mask; }
+
+    private:
+        friend unsigned int scheduler_run(void);
+        friend bool scheduler_next_wake(uint32_t *wake_us);
+        friend void scheduler_add(Task &task);
+        friend void scheduler_print_stats(Print &out);
+
+        TaskFunc _func;
+        const char *_name;
+        void *_ctx;
+        Task *_next;
+
+        volatile uint32_t _flags;
+        uint32_t _wait_mask;    // waiting for any of these flags, 0 if not
+        uint32_t _wake_us;      // micros() to wake at, if _sleeping
+        bool _sleeping;
+        bool _done;
+
+        uint32_t _runtime_us;
+        uint32_t _runs;
+
+        bool ready(uint32_t now) const;
+};
+
+#define TASK_BEGIN(t)       switch ((t)._lc) { case 0:
+
+#define TASK_END(t)         } (t)._lc = 0; return TASK_DONE
+
+// let other tasks run, then continue
+#define TASK_YIELD(t)       do { (t)._lc = __LINE__; return TASK_READY; case __LINE__:; } while (0)
+
+#define TASK_SLEEP_US(t, us) \
+    do { (t)._sleep_us(us); (t)._lc = __LINE__; return TASK_WAITING; case __LINE__:; } while (0)
+#define TASK_SLEEP_MS(t, ms) TASK_SLEEP_US(t, (ms) * 1000ul)
+
+// Re-check cond on every scheduler pass. This keeps delay() from sleeping,
+// prefer flags or a TASK_SLEEP poll interval when possible.
+#define TASK_WAIT_UNTIL(t, cond) \
+    do { (t)._lc = __LINE__; case __LINE__: if (!(cond)) return TASK_READY; } while (0)
+
+// Wait until any flag in mask is signalled. The flags aren't cleared, use take().
+#define TASK_WAIT_FLAGS(t, mask) \
+    do { (t)._wait_flags(mask); (t)._lc = __LINE__; return TASK_WAITING; case __LINE__:; } while (0)
+
+// Wait for a flag in mask or a timeout, whichever comes first
+#define TASK_WAIT_FLAGS_MS(t, mask, ms) \
+    do { (t)._wait_flags(mask); (t)._sleep_us((ms) * 1000ul); (t)._lc = __LINE__; \
+         return TASK_WAITING; case __LINE__:; } while (0)
+
+// Tasks run in the order they're added
+void scheduler_add(Task &task);
+
+// Run every ready task once. Returns the number of tasks run. Nested calls
+// (a task calling delay() or yield()) return 0 immediately.
+unsigned int scheduler_run(void);
+
+// Earliest micros() at which a task needs to run, false if every task is
+// waiting for flags (or done). A task that's ready now returns micros().
+// Call with interrupts masked and keep them masked until sleeping, otherwise
+// a Task::signal() from an interrupt right after the check is missed and the
+// sleep runs to the stale wake time. It never unmasks them itself.
+bool scheduler_next_wake(uint32_t *wake_us);
+
+// Print a table of task names, run counts, and total run times
+void scheduler_print_stats(Print &out);
+
+#endif // SCHEDULER_H
@@ -20,13 +20,7 @@
 #include <sam.h>
 #include <stddef.h> // for NULL
 #include "Timeout.h"
-
-#ifndef F_CPU
-#include "variant.h"
-#endif
-
-// 65536*1024 / 48MHz = 1.398101s = 1398101us
-#define MAX_TIMEOUT_US ((65536ul * 1024ul) / (F_CPU / 1000000ul))
+#include "tc_prescaler.h"
 
 static void(*timeout_callback)(void) = NULL;
 
@@ -104,52 +98,31 @@ void timeout_init(void)
 
 void timeout_set_us(uint32_t timeout_us)
 {
-    static const struct {
-        uint32_t scale;
-        uint32_t prescaler;
-    } prescaler_table[8] = {
-        { 1 <<  0, TC_CTRLA_PRESCALER_DIV1 },
-        { 1 <<  1, TC_CTRLA_PRESCALER_DIV2 },
-        { 1 <<  2, TC_CTRLA_PRESCALER_DIV4 },
-        { 1 <<  3, TC_CTRLA_PRESCALER_DIV8 },
-        { 1 <<  4, TC_CTRLA_PRESCALER_DIV16 },
-        { 1 <<  6, TC_CTRLA_PRESCALER_DIV64 },
-        { 1 <<  8, TC_CTRLA_PRESCALER_DIV256 },
-        { 1 << 10, TC_CTRLA_PRESCALER_DIV1024 },
-    };
-
-    uint32_t prescaler, cc;
-
-    if (timeout_us >= MAX_TIMEOUT_US)
-    {
-        // max pulse width is (65536*1024)/48MHz = 1.398101sec
-        // To avoid overflow, hard-cap the max settings here
-        prescaler = TC_CTRLA_PRESCALER_DIV1024;
-        cc = 0xffff;
-    }
-    else
-    {
-        unsigned int i;
-        for (i = 0; i < 8; i++)
-        {
-            cc = (timeout_us * (F_CPU / 1000000)) / prescaler_table[i].scale - 1;
-            if (cc < 65536)
-                break;
-        }
-        prescaler = prescaler_table[i].prescaler;
-    }
+    const uint32_t prescaler = tc_prescaler_for_us(timeout_us);
+    timeout_set_prescaler_cc(prescaler, tc_cc_for_us(timeout_us, prescaler));
+}
 
-    // stop and disable because the prescaler in CTRLA is enable-protected
+void timeout_set_prescaler_cc(uint32_t prescaler, uint16_t cc)
+{
+    // CC0 isn't buffered, so stop first or the count could already be past
+    // a smaller CC0 and run on to 0xffff
     timeout_stop();
-    timeout_disable();
 
-    TC5->COUNT16.CTRLA.reg = (TC5->COUNT16.CTRLA.reg & ~TC_CTRLA_PRESCALER_Msk) | prescaler;
-    timeout_sync();
-    TC5->COUNT16.CC[0].reg = (uint16_t)cc;
+    if (TC5->COUNT16.CTRLA.bit.PRESCALER != prescaler)
+    {
+        // disable because the prescaler in CTRLA is enable-protected
+        timeout_disable();
+        TC5->COUNT16.CTRLA.reg = (TC5->COUNT16.CTRLA.reg & ~TC_CTRLA_PRESCALER_Msk) | TC_CTRLA_PRESCALER(prescaler);
+        timeout_sync();
+        timeout_enable();
+    }
+
+    TC5->COUNT16.CC[0].reg = cc;
     timeout_sync();
 
-    // re-enable
-    timeout_enable();
+    // restart the timeout from 0, same as the stop/enable cycle always did
+    TC5->COUNT16.CTRLBSET.reg = TC_CTRLBSET_CMD_RETRIGGER;
+    timeout_sync();
 }
 
 void timeout_start(void)
@@ -169,3 +142,12 @@ void timeout_set_callback(void(*callback)(void))
 {
     timeout_callback = callback;
 }
+
+void timeout_set_event_start(bool enable)
+{
+    // EVCTRL is enable-protected
+    timeout_stop();
+    timeout_disable();
+    TC5->COUNT16.EVCTRL.reg = enable ? (TC_EVCTRL_TCEI | TC_EVCTRL_EVACT_RETRIGGER) : 0;
+    timeout_enable();
+}
@@ -20,17 +20,40 @@
 #ifndef TIMEOUT_H
 #define TIMEOUT_H
 
+#include <stdbool.h>
+#include <stdint.h>
+#include "tc_prescaler.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 void timeout_init(void);
 void timeout_set_us(uint32_t timeout_us);
+
+// Set the CTRLA.PRESCALER field value and CC0, and restart the timeout from 0
+// like timeout_start(). TC5 is only disabled when the prescaler changes.
+void timeout_set_prescaler_cc(uint32_t prescaler, uint16_t cc);
+
 void timeout_start(void);
 void timeout_stop(void);
 void timeout_set_callback(void(*callback)(void));
 
+// Let a TC5 event input (EVSYS_ID_USER_TC5_EVU) restart the timeout the same
+// as timeout_start(), with no CPU involvement. Route a generator to it with
+// EventRoute. The event needs the SYNC or RESYNC path.
+void timeout_set_event_start(bool enable);
+
 #ifdef __cplusplus
 }
+
+// timeout_set_us() for a constant period, computed at compile time
+template<uint32_t timeout_us>
+static inline void timeout_set_us(void)
+{
+    constexpr uint32_t prescaler = tc_prescaler_for_us(timeout_us);
+    constexpr uint16_t cc = tc_cc_for_us(timeout_us, prescaler);
+    timeout_set_prescaler_cc(prescaler, cc);
+}
 #endif
 #endif // TIMEOUT_H
@@ -19,45 +19,51 @@
 
 #include <sam.h>
 #include "Timer.h"
+#include "wiring_constants.h"
+#include "WInterrupts.h"
+#include "EventRoute.h"
 
-#ifndef F_CPU
-#include "variant.h"
-#endif
-
-// 65536*1024 / 48MHz = 1.398101s = 1398101us
-#define MAX_TIMEOUT_US ((65536ul * 1024ul) / (F_CPU / 1000000ul))
-
-int Timer::get_timer_info(uint32_t *clk_id, IRQn_Type *irqn)
+int Timer::get_timer_info(uint32_t *clk_id, IRQn_Type *irqn, uint32_t *evsys_user)
 {
+    uint32_t user;
+
     if (tc16 == &TC3->COUNT16)
     {
         *clk_id = GCLK_CLKCTRL_ID_TCC2_TC3_Val;
         *irqn = TC3_IRQn;
-        return 0;
+        user = EVSYS_ID_USER_TC3_EVU;
     }
     else if (tc16 == &TC4->COUNT16)
     {
         *clk_id = GCLK_CLKCTRL_ID_TC4_TC5_Val;
         *irqn = TC4_IRQn;
-        return 0;
+        user = EVSYS_ID_USER_TC4_EVU;
     }
     else if (tc16 == &TC5->COUNT16)
     {
         *clk_id = GCLK_CLKCTRL_ID_TC4_TC5_Val;
         *irqn = TC5_IRQn;
-        return 0;
+        user = EVSYS_ID_USER_TC5_EVU;
+    }
+    else
+    {
+        return 1;
     }
 
-    return 1;
+    if (evsys_user != NULL)
+        *evsys_user = user;
+    return 0;
 }
 
-void Timer::init(void)
+// Clock and reset the TC and set CTRLA, leaving it disabled with its IRQ
+// disabled. Returns the IRQ number, or -1 for an invalid TC.
+int Timer::reset(uint32_t ctrla)
 {
     uint32_t clk_id;
     IRQn_Type irqn;
 
     if (get_timer_info(&clk_id, &irqn) != 0)
-        return;
+        return -1;
 
     // disable IRQ and set priority
     NVIC_DisableIRQ(irqn);
@@ -76,22 +82,32 @@ void Timer::init(void)
     while (tc16->CTRLA.bit.SWRST);
 
     // setup CTRLA reg
-    tc16->CTRLA.reg |=
+    tc16->CTRLA.reg |= ctrla;
+    sync();
+
+    return irqn;
+}
+
+void Timer::init(bool periodic)
+{
+    int irqn = reset(
         TC_CTRLA_MODE(TC_CTRLA_MODE_COUNT16_Val)    |     // 16-bit counter mode
         TC_CTRLA_WAVEGEN(TC_CTRLA_WAVEGEN_MFRQ_Val) |     // match frequency mode
-        TC_CTRLA_PRESCALER(TC_CTRLA_PRESCALER_DIV1_Val);  // 1x prescaler
-    sync();
+        TC_CTRLA_PRESCALER(TC_CTRLA_PRESCALER_DIV1_Val)); // 1x prescaler
+    if (irqn < 0)
+        return;
 
     // default timeout = 1ms
     tc16->CC[0].reg = 48000-1;
     sync();
 
     // default oneshot mode on
-    tc16->CTRLBSET.reg = TC_CTRLBSET_ONESHOT;
+    if (!periodic)
+        tc16->CTRLBSET.reg = TC_CTRLBSET_ONESHOT;
 
     // enable interrupt for overflow
-    // in MFRQ one-shot, overflow is when the count hits TOP, i.e. CC0
-    // If not using one-shot, we'd want the MC0 interrupt
+    // in MFRQ, overflow is when the count hits TOP, i.e. CC0, and wraps to 0.
+    // That's the end of the one-shot, or of each period in periodic mode.
     tc16->INTENSET.reg = TC_INTENSET_OVF;
 
     // enable
@@ -99,55 +115,77 @@ void Timer::init(void)
     sync();
 
     // enable IRQ
-    NVIC_EnableIRQ(irqn);
+    NVIC_EnableIRQ((IRQn_Type)irqn);
+}
+
+int Timer::init_capture(uint32_t pin, uint32_t prescaler, bool invert)
+{
+    uint32_t clk_id, evsys_user;
+    IRQn_Type tc_irqn;
+
+    if (get_timer_info(&clk_id, &tc_irqn, &evsys_user) != 0)
+        return -1;
+
+    // The EIC event output follows the pin level, the TC acts on its edges
+    int extint = attachInterruptEvent(pin, HIGH);
+    if (extint < 0)
+        return -1;
+
+    // EXTINT -> EVSYS channel -> TC event input. Asynchronous path, so the
+    // edge timing isn't quantized by the EVSYS clock.
+    if (_evsys_channel >= 0)
+        event_route_disconnect(_evsys_channel);
+    _evsys_channel = event_route_connect(event_gen_extint(extint), evsys_user,
+                                         EVENT_PATH_ASYNC, EVENT_EDGE_NONE);
+    if (_evsys_channel < 0)
+        return -1;
+
+    int irqn = reset(
+        TC_CTRLA_MODE(TC_CTRLA_MODE_COUNT16_Val)    |     // 16-bit counter mode
+        TC_CTRLA_WAVEGEN(TC_CTRLA_WAVEGEN_NFRQ_Val) |     // count to 0xffff
+        TC_CTRLA_PRESCALER(prescaler));
+    if (irqn < 0)
+        return -1;
+
+    // Period and pulse width capture: on the event the count is captured in
+    // CC0 and restarted, then at the opposite edge the count goes in CC1.
+    tc16->EVCTRL.reg = TC_EVCTRL_TCEI | TC_EVCTRL_EVACT_PPW | (invert ? TC_EVCTRL_TCINV : 0);
+    tc16->CTRLC.reg = TC_CTRLC_CPTEN0 | TC_CTRLC_CPTEN1;
+    sync();
+
+    // MC0 is set once a full period has been captured
+    tc16->INTENSET.reg = TC_INTENSET_MC0;
+
+    enable();
+    NVIC_EnableIRQ((IRQn_Type)irqn);
+    return 0;
 }
 
 void Timer::set_us(uint32_t timeout_us)
 {
-    static const struct {
-        uint32_t scale;
-        uint32_t prescaler;
-    } prescaler_table[8] = {
-        { 1 <<  0, TC_CTRLA_PRESCALER_DIV1 },
-        { 1 <<  1, TC_CTRLA_PRESCALER_DIV2 },
-        { 1 <<  2, TC_CTRLA_PRESCALER_DIV4 },
-        { 1 <<  3, TC_CTRLA_PRESCALER_DIV8 },
-        { 1 <<  4, TC_CTRLA_PRESCALER_DIV16 },
-        { 1 <<  6, TC_CTRLA_PRESCALER_DIV64 },
-        { 1 <<  8, TC_CTRLA_PRESCALER_DIV256 },
-        { 1 << 10, TC_CTRLA_PRESCALER_DIV1024 },
-    };
-
-    uint32_t prescaler, cc;
-
-    if (timeout_us >= MAX_TIMEOUT_US)
-    {
-        // max pulse width is (65536*1024)/48MHz = 1.398101sec
-        // To avoid overflow, hard-cap the max settings here
-        prescaler = TC_CTRLA_PRESCALER_DIV1024;
-        cc = 0xffff;
-    }
-    else
-    {
-        unsigned int i;
-        for (i = 0; i < 8; i++)
-        {
-            cc = (timeout_us * (F_CPU / 1000000)) / prescaler_table[i].scale - 1;
-            if (cc < 65536)
-                break;
-        }
-        prescaler = prescaler_table[i].prescaler;
-    }
+    const uint32_t prescaler = tc_prescaler_for_us(timeout_us);
+    set_prescaler_cc(prescaler, tc_cc_for_us(timeout_us, prescaler));
+}
 
-    // stop and disable because the prescaler in CTRLA is enable-protected
+void Timer::set_prescaler_cc(uint32_t prescaler, uint16_t cc)
+{
+    // CC0 isn't buffered, so stop first or the count could already be past
+    // a smaller CC0 and run on to 0xffff
     stop();
-    disable();
 
-    tc16->CTRLA.reg = (tc16->CTRLA.reg & ~TC_CTRLA_PRESCALER_Msk) | prescaler;
-    sync();
-    tc16->CC[0].reg = (uint16_t)cc;
+    if (tc16->CTRLA.bit.PRESCALER != prescaler)
+    {
+        // disable because the prescaler in CTRLA is enable-protected
+        disable();
+        tc16->CTRLA.reg = (tc16->CTRLA.reg & ~TC_CTRLA_PRESCALER_Msk) | TC_CTRLA_PRESCALER(prescaler);
+        sync();
+        enable();
+    }
+
+    tc16->CC[0].reg = cc;
     sync();
 
-    // re-enable
-    enable();
+    // restart the period from 0, same as the stop/enable cycle always did
+    tc16->CTRLBSET.reg = TC_CTRLBSET_CMD_RETRIGGER;
+    sync();
 }
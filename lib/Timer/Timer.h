@@ -22,19 +22,24 @@
 
 #include <sam.h>
 #include <stddef.h> // for NULL
+#include "tc_prescaler.h"
 
-// this macro must be called to hook up a class instance to the right TC IRQ
-#define DECLARE_TIMER_HANDLER(_tc, _timer)          \
-    void _tc##_Handler(void) {                      \
-        void(*cb)(void) = _timer.get_callback();    \
-        if (cb != NULL) cb();                       \
-        _tc->COUNT16.INTFLAG.reg = TC_INTFLAG_OVF;  \
+// this macro must be called to hook up a class instance to the right TC IRQ.
+// Whichever flags were set on entry (OVF, or MC0 and ERR in capture mode) are
+// cleared after the callback.
+#define DECLARE_TIMER_HANDLER(_tc, _timer)                  \
+    void _tc##_Handler(void) {                              \
+        uint8_t flags = _tc->COUNT16.INTFLAG.reg;           \
+        void(*cb)(void) = _timer.get_callback();            \
+        if (cb != NULL) cb();                               \
+        _tc->COUNT16.INTFLAG.reg = flags;                   \
     }
 
 class Timer
 {
     public:
-        Timer(Tc *tc, void(*callback)(void)=NULL) : tc16(&tc->COUNT16), _callback(callback) { }
+        Timer(Tc *tc, void(*callback)(void)=NULL) :
+            tc16(&tc->COUNT16), _callback(callback), _evsys_channel(-1) { }
         inline void enable(void)  { tc16->CTRLA.reg |=  TC_CTRLA_ENABLE; sync(); }
         inline void disable(void) { tc16->CTRLA.reg &= ~TC_CTRLA_ENABLE; sync(); }
         inline void set_callback(void(*callback)(void)) { _callback = callback; }
@@ -51,15 +56,70 @@ class Timer
             tc16->COUNT.reg = 0;
         }
 
-        void init(void);
+        // Set up the timer in MFRQ mode with a 1ms period. In one-shot mode,
+        // start() runs one period. In periodic mode the hardware restarts at
+        // the end of each period, so there's no software restart jitter.
+        // set_us() on a running periodic timer cuts the current period short
+        // and starts the new one from 0, so it never runs past CC0 to 0xffff.
+        void init(bool periodic=false);
         void set_us(uint32_t timeout_us);
 
+        inline void set_periodic(bool periodic)
+        {
+            if (periodic)
+                tc16->CTRLBCLR.reg = TC_CTRLBCLR_ONESHOT;
+            else
+                tc16->CTRLBSET.reg = TC_CTRLBSET_ONESHOT;
+            sync();
+        }
+
+        // set_us() for a constant period, the prescaler and CC are computed at compile time
+        template<uint32_t timeout_us>
+        inline void set_us(void)
+        {
+            constexpr uint32_t prescaler = tc_prescaler_for_us(timeout_us);
+            constexpr uint16_t cc = tc_cc_for_us(timeout_us, prescaler);
+            set_prescaler_cc(prescaler, cc);
+        }
+
+        // Set the CTRLA.PRESCALER field value and CC0, and restart the count
+        // from 0 with the new period like start(). The TC is only disabled
+        // when the prescaler changes.
+        void set_prescaler_cc(uint32_t prescaler, uint16_t cc);
+
+        /*
+         * Input capture mode. The pin's EXTINT is routed through a free EVSYS
+         * channel (from EventRoute) to the TC, which restarts the count on each rising edge
+         * (falling if invert is set) and captures the period in CC0 and the
+         * high (low) time in CC1, in prescaled GCLK0 ticks. The callback runs
+         * after each period is captured, and calls capture_period() and
+         * capture_width().
+         * Don't use set_us() or set_prescaler_cc() in capture mode.
+         * Returns 0 on success, -1 if the pin has no EXTINT or no EVSYS
+         * channel is free.
+         */
+        int init_capture(uint32_t pin, uint32_t prescaler=TC_CTRLA_PRESCALER_DIV1_Val,
+                         bool invert=false);
+
+        inline uint16_t capture_period(void) { return read_cc(0); }
+        inline uint16_t capture_width(void)  { return read_cc(1); }
+
     private:
         TcCount16 *tc16;
         void(*_callback)(void);
+        int _evsys_channel;
 
         inline void sync(void) { while (tc16->STATUS.bit.SYNCBUSY); }
-        int get_timer_info(uint32_t *gclk_clkctrl_id, IRQn_Type *irqn);
+        int get_timer_info(uint32_t *gclk_clkctrl_id, IRQn_Type *irqn, uint32_t *evsys_user=NULL);
+        int reset(uint32_t ctrla);
+
+        // CC registers need a read request to synchronize
+        inline uint16_t read_cc(unsigned int n)
+        {
+            tc16->READREQ.reg = TC_READREQ_RREQ | TC_READREQ_ADDR(TC_COUNT16_CC_OFFSET + 2 * n);
+            sync();
+            return tc16->CC[n].reg;
+        }
 };
 
 #endif // TIMER_H
@@ -0,0 +1,92 @@
+/*******************************************************************************
+ * SAMD21 TC prescaler and compare value calculation
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+/*
+ * Shared by Timer and Timeout to pick the smallest TC prescaler for which a
+ * period in microseconds fits in a 16-bit MFRQ compare value. The prescalers
+ * are all powers of two, so this is done with shifts rather than dividing for
+ * each table entry. The functions are constexpr in C++, so a constant period
+ * costs nothing at runtime.
+ */
+
+#ifndef TC_PRESCALER_H
+#define TC_PRESCALER_H
+
+#include <stdint.h>
+
+#ifndef F_CPU
+#include "variant.h"
+#endif
+
+#ifdef __cplusplus
+#define TC_PRESCALER_CONSTEXPR constexpr
+#else
+#define TC_PRESCALER_CONSTEXPR
+#endif
+
+#define TC_TICKS_PER_US (F_CPU / 1000000ul)
+
+// 65536*1024 / 48MHz = 1.398101s = 1398101us
+#define TC_MAX_TIMEOUT_US ((65536ul * 1024ul) / TC_TICKS_PER_US)
+
+// log2 of the divider for a CTRLA.PRESCALER field value:
+// DIV1, DIV2, DIV4, DIV8, DIV16, DIV64, DIV256, DIV1024
+static inline TC_PRESCALER_CONSTEXPR uint32_t tc_prescaler_shift(uint32_t prescaler)
+{
+    return prescaler <= 4 ? prescaler : 2 * prescaler - 4;
+}
+
+// CTRLA.PRESCALER field value (not shifted into position) for a period
+static inline TC_PRESCALER_CONSTEXPR uint32_t tc_prescaler_for_us(uint32_t timeout_us)
+{
+    if (timeout_us >= TC_MAX_TIMEOUT_US)
+        return 7;
+    if (timeout_us == 0)
+        return 0;
+
+    // Smallest shift where (ticks >> shift) <= 65536, i.e. CC = (ticks >> shift) - 1
+    // fits. Counting the bits of (ticks - 1) >> 16 is exact except when
+    // ticks >> (shift - 1) is exactly 65536, which is checked below.
+    const uint32_t ticks = timeout_us * TC_TICKS_PER_US;
+    uint32_t over = (ticks - 1) >> 16;
+    uint32_t shift = 0;
+    while (over)
+    {
+        over >>= 1;
+        shift++;
+    }
+
+    // no DIV32, DIV128, or DIV512, round up to the next divider that exists
+    uint32_t prescaler = shift <= 4 ? shift : (shift + 5) / 2;
+    if (prescaler > 0 && (ticks >> tc_prescaler_shift(prescaler - 1)) <= 65536)
+        prescaler--;
+    return prescaler;
+}
+
+// MFRQ compare value for a period with the given prescaler field value
+static inline TC_PRESCALER_CONSTEXPR uint16_t tc_cc_for_us(uint32_t timeout_us, uint32_t prescaler)
+{
+    if (timeout_us >= TC_MAX_TIMEOUT_US)
+        return 0xffff;
+    if (timeout_us == 0)
+        return 0;
+    return (uint16_t)(((timeout_us * TC_TICKS_PER_US) >> tc_prescaler_shift(prescaler)) - 1);
+}
+
+#endif // TC_PRESCALER_H
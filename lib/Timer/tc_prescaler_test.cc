@@ -0,0 +1,69 @@
+/*
+ * tc_prescaler_test.cc: console application to check the shift-based
+ * tc_prescaler_for_us() and tc_cc_for_us() against the original division loop
+ * from Timer::set_us() and timeout_set_us(), for every period up to the max.
+ * Extension is .cc instead of .cpp so that the samd21 Makefile ignores it.
+ *
+ * Build and run:
+ *   g++ -O2 -Wall -DF_CPU=48000000ul -o tc_prescaler_test tc_prescaler_test.cc
+ *   ./tc_prescaler_test
+ */
+
+#include <stdio.h>
+
+#include "tc_prescaler.h"
+
+// the values must be usable at compile time
+static_assert(tc_prescaler_for_us(20000) == 4, "20ms prescaler");
+static_assert(tc_cc_for_us(20000, 4) == 59999, "20ms CC");
+
+// The original loop, returning the PRESCALER field value. It indexed past the
+// table for 0us, which is handled like the new code here.
+static uint32_t ref_prescaler(uint32_t timeout_us, uint32_t *cc)
+{
+    static const uint32_t scale[8] = { 1, 2, 4, 8, 16, 64, 256, 1024 };
+
+    if (timeout_us >= TC_MAX_TIMEOUT_US)
+    {
+        *cc = 0xffff;
+        return 7;
+    }
+    if (timeout_us == 0)
+    {
+        *cc = 0;
+        return 0;
+    }
+
+    unsigned int i;
+    for (i = 0; i < 8; i++)
+    {
+        *cc = (timeout_us * (F_CPU / 1000000)) / scale[i] - 1;
+        if (*cc < 65536)
+            break;
+    }
+    return i;
+}
+
+int main(void)
+{
+    unsigned long failures = 0;
+    uint32_t us;
+
+    for (us = 0; us <= TC_MAX_TIMEOUT_US + 1000; us++)
+    {
+        uint32_t ref_cc;
+        const uint32_t ref_p = ref_prescaler(us, &ref_cc);
+        const uint32_t p = tc_prescaler_for_us(us);
+        const uint16_t cc = tc_cc_for_us(us, p);
+
+        if (p != ref_p || cc != ref_cc)
+        {
+            if (failures++ < 10)
+                printf("FAIL %uus: prescaler %u cc %u, expected prescaler %u cc %u\n",
+                       us, p, cc, ref_p, ref_cc);
+        }
+    }
+
+    printf("%u periods checked, %lu failures\n", us, failures);
+    return failures ? 1 : 0;
+}
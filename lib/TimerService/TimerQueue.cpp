@@ -0,0 +1,151 @@
+/*******************************************************************************
+ * Intrusive deadline queue for software timers
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include "TimerQueue.h"
+
+// Join two heap roots, the later one becomes the leftmost child of the earlier
+TimerEvent *TimerQueue::meld(TimerEvent *a, TimerEvent *b)
+{
+    if (time_before(b->_deadline, a->_deadline))
+    {
+        TimerEvent *tmp = a;
+        a = b;
+        b = tmp;
+    }
+
+    b->_prev = a;
+    b->_sibling = a->_child;
+    if (a->_child != NULL)
+        a->_child->_prev = b;
+    a->_child = b;
+    return a;
+}
+
+// Combine a list of siblings into one heap using the standard two-pass
+// pairing. Done iteratively so the stack depth doesn't depend on the heap.
+TimerEvent *TimerQueue::merge_pairs(TimerEvent *first)
+{
+    if (first == NULL)
+        return NULL;
+
+    // first pass: meld pairs left to right, collecting them in reverse order
+    TimerEvent *pairs = NULL;
+    while (first != NULL)
+    {
+        TimerEvent *a = first;
+        TimerEvent *b = a->_sibling;
+        first = (b != NULL) ? b->_sibling : NULL;
+
+        a->_prev = a->_sibling = NULL;
+        if (b != NULL)
+        {
+            b->_prev = b->_sibling = NULL;
+            a = meld(a, b);
+        }
+
+        a->_sibling = pairs;
+        pairs = a;
+    }
+
+    // second pass: meld the pairs right to left into one heap
+    TimerEvent *result = pairs;
+    pairs = pairs->_sibling;
+    result->_sibling = NULL;
+    while (pairs != NULL)
+    {
+        TimerEvent *next = pairs->_sibling;
+        pairs->_sibling = NULL;
+        result = meld(result, pairs);
+        pairs = next;
+    }
+
+    return result;
+}
+
+void TimerQueue::insert(TimerEvent *ev)
+{
+    ev->_child = ev->_sibling = ev->_prev = NULL;
+    ev->_active = true;
+    _root = (_root == NULL) ? ev : meld(_root, ev);
+}
+
+void TimerQueue::remove(TimerEvent *ev)
+{
+    if (ev == _root)
+    {
+        _root = merge_pairs(ev->_child);
+    }
+    else
+    {
+        // unlink from the parent's child list
+        if (ev->_prev->_child == ev)
+            ev->_prev->_child = ev->_sibling;
+        else
+            ev->_prev->_sibling = ev->_sibling;
+        if (ev->_sibling != NULL)
+            ev->_sibling->_prev = ev->_prev;
+
+        // the removed event's children form a heap that goes back into the root
+        TimerEvent *sub = merge_pairs(ev->_child);
+        if (sub != NULL)
+            _root = meld(_root, sub);
+    }
+
+    ev->_child = ev->_sibling = ev->_prev = NULL;
+    ev->_active = false;
+}
+
+void TimerQueue::schedule(TimerEvent &ev, uint32_t deadline, uint32_t period)
+{
+    if (ev._active)
+        remove(&ev);
+    ev._deadline = deadline;
+    ev._period = period;
+    insert(&ev);
+}
+
+void TimerQueue::cancel(TimerEvent &ev)
+{
+    if (ev._active)
+        remove(&ev);
+}
+
+TimerEvent *TimerQueue::pop_expired(uint32_t now)
+{
+    TimerEvent *ev = _root;
+    if (ev == NULL || time_before(now, ev->_deadline))
+        return NULL;
+
+    remove(ev);
+
+    if (ev->_period != 0)
+    {
+        uint32_t next = ev->_deadline + ev->_period;
+        if (!time_before(now, next))
+        {
+            // fell behind by at least a whole period. This should be rare, so
+            // the division is fine here.
+            next += ((now - next) / ev->_period + 1) * ev->_period;
+        }
+        ev->_deadline = next;
+        insert(ev);
+    }
+
+    return ev;
+}
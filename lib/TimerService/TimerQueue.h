@@ -0,0 +1,116 @@
+/*******************************************************************************
+ * Intrusive deadline queue for software timers
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+/*
+ * A pairing heap of TimerEvents ordered by deadline. The heap links live in
+ * the events themselves, so there's no allocation and no limit on the number
+ * of events. Insert is O(1), removing the earliest or cancelling any event is
+ * O(log n) amortized.
+ *
+ * Times are free-running 32-bit tick counts compared with wraparound, so all
+ * pending deadlines must be within 2^31 ticks of each other.
+ *
+ * TimerQueue doesn't know about hardware or interrupts, the caller has to
+ * serialize access. See TimerService.h for the TC3-backed instance.
+ */
+
+#ifndef TIMERQUEUE_H
+#define TIMERQUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+class TimerEvent
+{
+    public:
+        typedef void (*Callback)(void *ctx);
+
+        TimerEvent(Callback callback, void *ctx=NULL) :
+            _callback(callback), _ctx(ctx), _deadline(0), _period(0),
+            _child(NULL), _sibling(NULL), _prev(NULL), _active(false) { }
+
+        inline bool active(void) const { return _active; }
+        inline uint32_t deadline(void) const { return _deadline; }
+        inline uint32_t period(void) const { return _period; }
+
+        inline void fire(void) { _callback(_ctx); }
+
+    private:
+        friend class TimerQueue;
+
+        Callback _callback;
+        void *_ctx;
+        uint32_t _deadline;
+        uint32_t _period;       // 0 for one-shot
+
+        // pairing heap links. _prev is the parent for the leftmost child,
+        // otherwise the previous sibling.
+        TimerEvent *_child;
+        TimerEvent *_sibling;
+        TimerEvent *_prev;
+
+        bool _active;
+};
+
+class TimerQueue
+{
+    public:
+        TimerQueue() : _root(NULL) { }
+
+        // Add an event (or move it if it's already queued). If period is
+        // non-zero, the event is re-queued at deadline+period each time it's
+        // popped, so periodic events don't drift with dispatch latency.
+        void schedule(TimerEvent &ev, uint32_t deadline, uint32_t period=0);
+
+        // Remove an event if it's queued
+        void cancel(TimerEvent &ev);
+
+        inline bool empty(void) const { return _root == NULL; }
+
+        // Earliest deadline, false if the queue is empty
+        inline bool next_deadline(uint32_t *deadline) const
+        {
+            if (_root == NULL)
+                return false;
+            *deadline = _root->_deadline;
+            return true;
+        }
+
+        // Remove and return the earliest event if its deadline is at or before
+        // now, otherwise NULL. The caller should call fire() on it.
+        // A periodic event is re-queued before it's returned, so the callback
+        // may cancel it. If whole periods were missed, they're skipped but the
+        // phase is kept.
+        TimerEvent *pop_expired(uint32_t now);
+
+        static inline bool time_before(uint32_t a, uint32_t b)
+        {
+            return (int32_t)(a - b) < 0;
+        }
+
+    private:
+        TimerEvent *_root;
+
+        void insert(TimerEvent *ev);
+        void remove(TimerEvent *ev);
+        static TimerEvent *meld(TimerEvent *a, TimerEvent *b);
+        static TimerEvent *merge_pairs(TimerEvent *first);
+};
+
+#endif // TIMERQUEUE_H
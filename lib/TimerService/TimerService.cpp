@@ -0,0 +1,201 @@
+/*******************************************************************************
+ * SAMD21 TimerService library. Many software timers on one TC
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include <sam.h>
+#include "TimerService.h"
+
+#ifndef F_CPU
+#include "variant.h"
+#endif
+
+static_assert(F_CPU / 16 == TIMER_SERVICE_TICKS_PER_US * 1000000ul,
+              "TIMER_SERVICE_TICKS_PER_US doesn't match F_CPU / 16");
+
+#define TS_TC (&TC3->COUNT16)
+
+static TimerQueue queue;
+
+// upper 16 bits of the tick count, incremented on every overflow
+static volatile uint32_t ticks_hi = 0;
+
+static inline void ts_sync(void)
+{
+    while (TS_TC->STATUS.bit.SYNCBUSY);
+}
+
+// mask interrupts, return the previous state for irq_restore
+static inline uint32_t irq_save(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    return primask;
+}
+
+static inline void irq_restore(uint32_t primask)
+{
+    __set_PRIMASK(primask);
+}
+
+uint32_t timer_service_ticks(void)
+{
+    const uint32_t primask = irq_save();
+    uint32_t hi = ticks_hi;
+    const uint16_t lo = TS_TC->COUNT.reg;
+    const bool ovf = TS_TC->INTFLAG.bit.OVF;
+    irq_restore(primask);
+
+    // an overflow the ISR hasn't handled yet applies only if lo already wrapped
+    if (ovf && lo < 0x8000)
+        hi += 0x10000;
+    return hi | lo;
+}
+
+// Program CC0 for the earliest deadline. Called with interrupts masked.
+// Returns true if the earliest event is already due and should be run now.
+static bool ts_arm(void)
+{
+    uint32_t deadline;
+    if (!queue.next_deadline(&deadline))
+    {
+        TS_TC->INTENCLR.reg = TC_INTENCLR_MC0;
+        return false;
+    }
+
+    const int32_t delta = (int32_t)(deadline - timer_service_ticks());
+    if (delta >= 0x10000)
+    {
+        // not in this counter period, the overflow interrupt will check again
+        TS_TC->INTENCLR.reg = TC_INTENCLR_MC0;
+        return false;
+    }
+
+    if (delta > TIMER_SERVICE_MIN_TICKS)
+    {
+        TS_TC->CC[0].reg = (uint16_t)deadline;
+        TS_TC->INTFLAG.reg = TC_INTFLAG_MC0;
+        TS_TC->INTENSET.reg = TC_INTENSET_MC0;
+        return false;
+    }
+
+    // too close to program reliably, wait for it
+    while ((int32_t)(deadline - timer_service_ticks()) > 0);
+    return true;
+}
+
+// Run everything that's due, then program the next deadline
+static void ts_dispatch(void)
+{
+    while (true)
+    {
+        uint32_t primask = irq_save();
+        TimerEvent *ev = queue.pop_expired(timer_service_ticks());
+        if (ev == NULL)
+        {
+            bool due = ts_arm();
+            irq_restore(primask);
+            if (!due)
+                break;
+            continue;
+        }
+        irq_restore(primask);
+
+        ev->fire();
+    }
+}
+
+void TC3_Handler(void)
+{
+    if (TS_TC->INTFLAG.bit.OVF)
+    {
+        TS_TC->INTFLAG.reg = TC_INTFLAG_OVF;
+        ticks_hi += 0x10000;
+    }
+    TS_TC->INTFLAG.reg = TC_INTFLAG_MC0;
+
+    ts_dispatch();
+}
+
+void timer_service_init(void)
+{
+    NVIC_DisableIRQ(TC3_IRQn);
+    NVIC_ClearPendingIRQ(TC3_IRQn);
+    NVIC_SetPriority(TC3_IRQn, 0);
+
+    PM->APBCMASK.reg |= PM_APBCMASK_TC3;
+
+    GCLK->CLKCTRL.reg = (uint16_t)(GCLK_CLKCTRL_CLKEN | GCLK_CLKCTRL_GEN_GCLK0 |
+                                   GCLK_CLKCTRL_ID(GCLK_CLKCTRL_ID_TCC2_TC3_Val));
+    while (GCLK->STATUS.bit.SYNCBUSY);
+
+    // disable and reset
+    TS_TC->CTRLA.reg &= ~TC_CTRLA_ENABLE;
+    ts_sync();
+    TS_TC->CTRLA.reg = TC_CTRLA_SWRST;
+    ts_sync();
+    while (TS_TC->CTRLA.bit.SWRST);
+
+    // free-running 16-bit counter, TOP = 0xffff
+    TS_TC->CTRLA.reg =
+        TC_CTRLA_MODE(TC_CTRLA_MODE_COUNT16_Val)    |
+        TC_CTRLA_WAVEGEN(TC_CTRLA_WAVEGEN_NFRQ_Val) |
+        TC_CTRLA_PRESCALER(TC_CTRLA_PRESCALER_DIV16_Val);
+    ts_sync();
+
+    // keep COUNT continuously synchronized so reads don't need a READREQ
+    TS_TC->READREQ.reg = TC_READREQ_RCONT | TC_READREQ_ADDR(TC_COUNT16_COUNT_OFFSET);
+    ts_sync();
+
+    ticks_hi = 0;
+    TS_TC->INTFLAG.reg = TC_INTFLAG_MASK;
+    TS_TC->INTENSET.reg = TC_INTENSET_OVF;
+
+    TS_TC->CTRLA.reg |= TC_CTRLA_ENABLE;
+    ts_sync();
+
+    NVIC_EnableIRQ(TC3_IRQn);
+}
+
+void timer_service_start_at(TimerEvent &ev, uint32_t deadline_ticks, uint32_t period_ticks)
+{
+    uint32_t primask = irq_save();
+    queue.schedule(ev, deadline_ticks, period_ticks);
+    bool due = ts_arm();
+    irq_restore(primask);
+
+    // let the ISR run anything that's already due so callbacks always run there
+    if (due)
+        NVIC_SetPendingIRQ(TC3_IRQn);
+}
+
+void timer_service_start(TimerEvent &ev, uint32_t delay_us, uint32_t period_us)
+{
+    timer_service_start_at(ev, timer_service_ticks() + timer_service_us_to_ticks(delay_us),
+                           timer_service_us_to_ticks(period_us));
+}
+
+void timer_service_cancel(TimerEvent &ev)
+{
+    uint32_t primask = irq_save();
+    queue.cancel(ev);
+    bool due = ts_arm();
+    irq_restore(primask);
+
+    if (due)
+        NVIC_SetPendingIRQ(TC3_IRQn);
+}
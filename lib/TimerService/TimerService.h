@@ -0,0 +1,78 @@
+/*******************************************************************************
+ * SAMD21 TimerService library. Many software timers on one TC
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+/*
+ * TC3 free-runs at 3MHz (48MHz GCLK0 / 16) and its overflow interrupt extends
+ * the count to 32 bits. CC0 is set to the low half of the next deadline in the
+ * TimerQueue, so the match interrupt fires exactly on the deadline rather than
+ * after a restart delay like a one-shot timer would. Deadlines more than one
+ * counter period away are re-checked at each overflow.
+ *
+ * Callbacks run in the TC3 interrupt, and may start or cancel any event
+ * (including their own). TimerEvents must stay valid while they're active, so
+ * normally they're static or global.
+ *
+ *   static void led_off(void *) { led = 0; }
+ *   static TimerEvent led_off_event(led_off);
+ *   ...
+ *   timer_service_init();
+ *   timer_service_start(led_off_event, 20000);
+ *
+ * This uses TC3_Handler, so TC3 isn't available to Timer or analogWrite() on
+ * the TC3 pins (5 and 10).
+ */
+
+#ifndef TIMERSERVICE_H
+#define TIMERSERVICE_H
+
+#include <stdint.h>
+#include "TimerQueue.h"
+
+#define TIMER_SERVICE_TICKS_PER_US  3
+
+// longest delay or period, deadlines are compared as signed 32-bit tick counts
+#define TIMER_SERVICE_MAX_US        (0x7fffffffu / TIMER_SERVICE_TICKS_PER_US)
+
+// Deadlines closer than this are busy-waited rather than programmed into CC0,
+// because the CC0 write has to synchronize before it takes effect.
+#ifndef TIMER_SERVICE_MIN_TICKS
+#define TIMER_SERVICE_MIN_TICKS     8
+#endif
+
+void timer_service_init(void);
+
+// Current time in 3MHz ticks, wraps every 1431 seconds
+uint32_t timer_service_ticks(void);
+
+static inline uint32_t timer_service_us_to_ticks(uint32_t us)
+{
+    return (us > TIMER_SERVICE_MAX_US ? TIMER_SERVICE_MAX_US : us) * TIMER_SERVICE_TICKS_PER_US;
+}
+
+// Run ev once after delay_us, then every period_us if period_us isn't 0.
+// Restarts ev if it's already active.
+void timer_service_start(TimerEvent &ev, uint32_t delay_us, uint32_t period_us=0);
+
+// Run ev at an absolute time in ticks, then every period_ticks if non-zero.
+// For periodic events this keeps the phase relative to another timestamp.
+void timer_service_start_at(TimerEvent &ev, uint32_t deadline_ticks, uint32_t period_ticks=0);
+
+void timer_service_cancel(TimerEvent &ev);
+
+#endif // TIMERSERVICE_H
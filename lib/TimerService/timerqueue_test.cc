@@ -0,0 +1,199 @@
+/*
+ * timerqueue_test.cc: console application to simulate the TimerService
+ * dispatch loop on top of TimerQueue and check event ordering and jitter.
+ * Extension is .cc instead of .cpp so that the samd21 Makefile ignores it.
+ *
+ * A simulated clock starting just before the 32-bit wraparound advances by a
+ * random amount each step, standing in for interrupt latency. Random one-shot
+ * and periodic events are started and cancelled (including from callbacks)
+ * and checked against a reference std::multimap.
+ *
+ * Build and run:
+ *   g++ -O2 -Wall -Wextra -o timerqueue_test timerqueue_test.cc TimerQueue.cpp
+ *   ./timerqueue_test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <map>
+
+#include "TimerQueue.h"
+#include "../host_test.h"
+
+#define NUM_EVENTS      200
+#define MAX_LATENCY     20
+
+struct SimEvent
+{
+    int index;
+    uint32_t first;         // deadline when started
+    uint32_t deadline;      // current deadline
+    uint32_t fires;         // number of callbacks since started
+    bool cancel_self;
+    TimerEvent ev;
+
+    SimEvent() : index(0), first(0), deadline(0), fires(0), cancel_self(false), ev(callback, this) { }
+    static void callback(void *ctx);
+};
+
+static TimerQueue queue;
+static SimEvent events[NUM_EVENTS];
+static uint32_t sim_now;
+static uint32_t last_deadline;
+static bool have_last;
+static uint32_t max_jitter;
+static unsigned long total_fires;
+
+// reference model: 64-bit deadline -> event index
+static std::multimap<int64_t, int> ref;
+static int64_t sim_now64;
+
+static int64_t unwrap(uint32_t t)
+{
+    return sim_now64 + (int32_t)(t - sim_now);
+}
+
+static void ref_remove(int index)
+{
+    for (auto it = ref.begin(); it != ref.end(); ++it)
+    {
+        if (it->second == index)
+        {
+            ref.erase(it);
+            return;
+        }
+    }
+}
+
+void SimEvent::callback(void *ctx)
+{
+    SimEvent *se = static_cast<SimEvent *>(ctx);
+    se->fires++;
+    total_fires++;
+    if (se->cancel_self && se->ev.period() != 0 && se->fires == 3)
+    {
+        queue.cancel(se->ev);
+        ref_remove(se->index);
+    }
+}
+
+static void start_random(SimEvent &se)
+{
+    uint32_t delay = rand() % 5000;
+    uint32_t period = (rand() % 3 == 0) ? 1 + rand() % 2000 : 0;
+
+    ref_remove(se.index);
+    se.first = se.deadline = sim_now + delay;
+    se.fires = 0;
+    se.cancel_self = (rand() % 4 == 0);
+    queue.schedule(se.ev, se.first, period);
+    ref.insert(std::make_pair(unwrap(se.first), se.index));
+}
+
+// the body of the TC3 ISR: pop and fire everything due
+static void dispatch(void)
+{
+    TimerEvent *ev;
+    while ((ev = queue.pop_expired(sim_now)) != NULL)
+    {
+        SimEvent *se = NULL;
+        for (int i = 0; i < NUM_EVENTS; i++)
+            if (&events[i].ev == ev)
+                se = &events[i];
+
+        // the popped event must be the reference's earliest (ties in any order)
+        CHECK(!ref.empty(), "popped with empty reference");
+        const uint32_t deadline = se->deadline;
+        CHECK(unwrap(deadline) == ref.begin()->first, "event %d deadline %u, expected %lld",
+              se->index, deadline, (long long)ref.begin()->first);
+        CHECK(!have_last || !TimerQueue::time_before(deadline, last_deadline),
+              "out of order: %u after %u", deadline, last_deadline);
+        last_deadline = deadline;
+        have_last = true;
+
+        if (ev->period() != 0)
+        {
+            // no drift: re-queued at the first deadline + k*period after now
+            const uint32_t next = ev->deadline();
+            CHECK(ev->active(), "periodic event %d not re-queued", se->index);
+            CHECK((next - se->first) % ev->period() == 0,
+                  "event %d drifted: next %u first %u period %u",
+                  se->index, next, se->first, ev->period());
+            CHECK(TimerQueue::time_before(sim_now, next) &&
+                  !TimerQueue::time_before(sim_now, next - ev->period()),
+                  "event %d next deadline %u, now %u period %u",
+                  se->index, next, sim_now, ev->period());
+        }
+        else
+        {
+            CHECK(!ev->active(), "one-shot event %d still active", se->index);
+        }
+
+        const uint32_t jitter = sim_now - deadline;
+        if (jitter > max_jitter)
+            max_jitter = jitter;
+
+        ref_remove(se->index);
+        if (ev->active())
+        {
+            se->deadline = ev->deadline();
+            ref.insert(std::make_pair(unwrap(se->deadline), se->index));
+        }
+
+        ev->fire();
+    }
+
+    if (!ref.empty())
+    {
+        uint32_t next = 0;
+        CHECK(queue.next_deadline(&next), "queue empty, reference isn't");
+        CHECK(unwrap(next) == ref.begin()->first, "next deadline %u, expected %lld",
+              next, (long long)ref.begin()->first);
+    }
+    else
+    {
+        CHECK(queue.empty(), "queue not empty, reference is");
+    }
+}
+
+int main(void)
+{
+    srand(1);
+    sim_now64 = 0xffffffffu - 100000;
+    sim_now = (uint32_t)sim_now64;
+
+    for (int i = 0; i < NUM_EVENTS; i++)
+    {
+        events[i].index = i;
+        if (i % 2 == 0)
+            start_random(events[i]);
+    }
+
+    unsigned long steps = 0;
+    for (; steps < 2000000; steps++)
+    {
+        // like the hardware, the ISR runs some time after the deadline
+        sim_now64 += 1 + rand() % MAX_LATENCY;
+        sim_now = (uint32_t)sim_now64;
+        dispatch();
+
+        // random start, restart and cancel from "main"
+        int r = rand() % 100;
+        SimEvent &se = events[rand() % NUM_EVENTS];
+        if (r < 5)
+        {
+            start_random(se);
+        }
+        else if (r < 7)
+        {
+            queue.cancel(se.ev);
+            ref_remove(se.index);
+            CHECK(!se.ev.active(), "cancelled event still active");
+        }
+    }
+
+    printf("%lu steps, %lu callbacks, max jitter %u ticks (step latency up to %u)\n",
+           steps, total_fires, max_jitter, MAX_LATENCY);
+    CHECK(max_jitter <= MAX_LATENCY, "jitter %u larger than the simulated latency", max_jitter);
+    return check_result();
+}
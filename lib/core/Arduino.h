@@ -54,6 +54,7 @@ extern "C"{
 #define microsecondsToClockCycles(a) ( (a) * (SystemCoreClock / 1000000L) )
 
 void yield( void ) ;
+int yieldNextWake( uint32_t *us ) ;
 
 /* system functions */
 int main( void );
@@ -0,0 +1,43 @@
+/*******************************************************************************
+ * Per-IRQ handler run time statistics
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include "Arduino.h"
+#include "IrqStats.h"
+
+#ifdef IRQ_STATS
+static const char * const irq_names[PERIPH_COUNT_IRQn] = {
+    "PM", "SYSCTRL", "WDT", "RTC", "EIC", "NVMCTRL", "DMAC", "USB", "EVSYS",
+    "SERCOM0", "SERCOM1", "SERCOM2", "SERCOM3", "SERCOM4", "SERCOM5",
+    "TCC0", "TCC1", "TCC2", "TC3", "TC4", "TC5", "TC6", "TC7",
+    "ADC", "AC", "DAC", "PTC", "I2S",
+};
+
+void irqStatsPrint(Print &out)
+{
+    out.printf("%-8s %10s %10s %8s\r\n"_fmt, "irq", "count", "avg_cyc", "max_cyc");
+    for (int irq = 0; irq < PERIPH_COUNT_IRQn; irq++)
+    {
+        IrqStats s;
+        if (irqStatsGet((IRQn_Type)irq, &s) != 0 || s.count == 0)
+            continue;
+        out.printf("%-8s %10u %10u %8u\r\n"_fmt, irq_names[irq], (unsigned)s.count,
+                   (unsigned)(s.totalCycles / s.count), (unsigned)s.maxCycles);
+    }
+}
+#endif
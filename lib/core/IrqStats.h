@@ -0,0 +1,72 @@
+/*******************************************************************************
+ * Per-IRQ handler run time statistics
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+/*
+ * With IRQ_STATS defined (e.g. in a sketch's config.mk), the vector table in
+ * cortex_handlers.c points the EIC, DMAC, USB, SERCOMx and TC3-5 interrupts
+ * at wrappers which count calls and time each handler in CPU cycles from
+ * SysTick VAL. Without it, there are no wrappers and these functions are
+ * empty inlines. cortex_handlers.o is linked into every sketch, so it is
+ * built per sketch in obj/<sketch>/ and rebuilt when the define changes.
+ *
+ * The times include the few cycles of wrapper overhead and any handler that
+ * preempts this one. Handlers that run longer than a SysTick period (1ms)
+ * wrap and are under-counted, and with DELAY_SLEEP_SUPPRESS_SYSTICK the
+ * handlers that wake the CPU count 0 since SysTick is stopped.
+ */
+
+#ifndef IRQ_STATS_H
+#define IRQ_STATS_H
+
+#include <stdint.h>
+#include "sam.h"
+
+typedef struct {
+    uint32_t count;
+    uint32_t maxCycles;
+    uint64_t totalCycles;
+} IrqStats;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef IRQ_STATS
+// Copy the stats for irq, returns -1 if it isn't instrumented
+int irqStatsGet(IRQn_Type irq, IrqStats *stats);
+void irqStatsReset(void);
+#else
+static inline int irqStatsGet(IRQn_Type irq, IrqStats *stats) { (void)irq; (void)stats; return -1; }
+static inline void irqStatsReset(void) { }
+#endif
+
+#ifdef __cplusplus
+} // extern "C"
+
+#include "Print.h"
+
+// Print a table of the handlers that have run
+#ifdef IRQ_STATS
+void irqStatsPrint(Print &out);
+#else
+static inline void irqStatsPrint(Print &out) { (void)out; }
+#endif
+#endif // __cplusplus
+
+#endif // IRQ_STATS_H
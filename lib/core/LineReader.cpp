@@ -0,0 +1,107 @@
+/*******************************************************************************
+ * Non-blocking line input for Stream objects
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include "LineReader.h"
+
+void LineReader::reset(void)
+{
+    _count = 0;
+    _ready = false;
+    _discarding = false;
+    _truncated = false;
+    _chunkPos = 0;
+    _chunkLen = 0;
+    _buf[0] = '\0';
+}
+
+bool LineReader::poll(Stream &stream)
+{
+    static const char CRLF[] = "\r\n";
+
+    if (_ready)
+    {
+        // start a new line after returning the last one
+        _ready = false;
+        _discarding = false;
+        _truncated = false;
+        _count = 0;
+        _buf[0] = '\0';
+    }
+
+    while (true)
+    {
+        if (_chunkPos == _chunkLen)
+        {
+            _chunkPos = 0;
+            _chunkLen = (uint8_t)stream.readAvailable(_chunk, sizeof(_chunk));
+            if (_chunkLen == 0)
+                return false;
+        }
+
+        // Ordinary characters are echoed verbatim, so echo runs of them with
+        // one write rather than a print(c) per character like readLine.
+        uint8_t run = _chunkPos;
+        while (_chunkPos < _chunkLen)
+        {
+            const char c = (char)_chunk[_chunkPos];
+            if (c == '\r' || (c == '\b' && _count && !_discarding))
+            {
+                if (_echo && _chunkPos != run)
+                    stream.write(&_chunk[run], _chunkPos - run);
+                _chunkPos++;
+                run = _chunkPos;
+
+                if (c == '\r')
+                {
+                    if (_echo) stream.print(CRLF);
+                    _ready = true;
+                    return true;
+                }
+
+                _buf[--_count] = '\0';
+                if (_echo) stream.print("\b \b");
+                continue;
+            }
+
+            _chunkPos++;
+            if (_discarding)
+            {
+                if (!_truncated)
+                {
+                    _truncated = true;
+                    _overflows++;
+                }
+                _dropped++;
+            }
+            else
+            {
+                _buf[_count++] = c;
+                _buf[_count] = '\0';
+                if (_count == _bufsize - 1)
+                {
+                    // like readLine, stop editing and throw out the rest of the line
+                    _discarding = true;
+                }
+            }
+        }
+
+        if (_echo && _chunkPos != run)
+            stream.write(&_chunk[run], _chunkPos - run);
+    }
+}
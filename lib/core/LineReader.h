@@ -0,0 +1,89 @@
+/*******************************************************************************
+ * Non-blocking line input for Stream objects
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#ifndef LINE_READER_H
+#define LINE_READER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "Stream.h"
+
+#ifndef LINE_READER_CHUNK_SIZE
+#define LINE_READER_CHUNK_SIZE 32
+#endif
+#if LINE_READER_CHUNK_SIZE > 255
+#error LINE_READER_CHUNK_SIZE must fit in a uint8_t
+#endif
+
+/*
+ * Incremental version of Stream::readLine. Call poll() from loop() and it
+ * consumes whatever input is available without waiting, returning true once a
+ * full line (terminated by CR) is in the buffer.
+ *
+ * Echo and backspace handling is the same as readLine: CR echoes CRLF,
+ * backspace erases a character and echoes "\b \b", and when the buffer fills
+ * up the rest of the line is echoed but discarded until the next CR.
+ *
+ * Input is read in chunks with Stream::readAvailable, so bytes after a CR stay
+ * buffered here for the next poll(). Don't mix other reads of the same
+ * stream with a LineReader.
+ */
+class LineReader
+{
+  public:
+    // bufsize must be at least 2
+    LineReader(char *buf, size_t bufsize, bool echo=false)
+      : _buf(buf), _bufsize(bufsize), _echo(echo), _overflows(0), _dropped(0) { reset(); }
+
+    template<size_t N>
+    LineReader(char (&buf)[N], bool echo=false) : LineReader(buf, N, echo) { }
+
+    // Read available input from stream (and echo to it). Returns true when a
+    // line is complete, which stays valid until the next call to poll().
+    bool poll(Stream &stream);
+
+    // Discard the current partial line and any buffered input
+    void reset(void);
+
+    const char *line(void) const { return _buf; }
+    size_t length(void) const { return _count; }
+
+    // Number of lines which were truncated, and total characters discarded
+    uint32_t overflows(void) const { return _overflows; }
+    uint32_t dropped(void) const { return _dropped; }
+
+  private:
+    char *_buf;
+    size_t _bufsize;
+    size_t _count;
+    bool _echo;
+    bool _ready;        // _buf holds a complete line returned by the last poll()
+    bool _discarding;   // _buf filled up, ignoring input until CR
+    bool _truncated;    // input was dropped from the current line
+
+    uint8_t _chunk[LINE_READER_CHUNK_SIZE];
+    uint8_t _chunkPos;
+    uint8_t _chunkLen;
+
+    uint32_t _overflows;
+    uint32_t _dropped;
+};
+
+#endif // LINE_READER_H
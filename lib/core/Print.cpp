@@ -16,15 +16,21 @@
   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 */
 
+#ifndef _GNU_SOURCE
 #define _GNU_SOURCE // for vasprintf
+#endif
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdarg.h>
 #include <string.h>
 #include <math.h>
+// conditional on __thumb__ so the host benchmarks can build Print on a PC
+#ifdef __thumb__
 #include "Arduino.h"
+#endif
 
 #include "Print.h"
+#include "fmtnum.h"
 
 // Public Methods //////////////////////////////////////////////////////////////
 
@@ -209,26 +215,24 @@ size_t Print::printf(const char *fmt, ...)
 
 size_t Print::printNumber(unsigned long n, uint8_t base)
 {
-  char buf[8 * sizeof(long) + 1]; // Assumes 8-bit chars plus zero byte.
-  char *str = &buf[sizeof(buf) - 1];
+  char buf[FMT_U32_MAX_LEN];
+  char *end = &buf[sizeof(buf)];
 
-  *str = '\0';
+  // fmt_u32 has shift/reciprocal fast paths for bases 2, 8, 10, and 16
+  char *str = fmt_u32(end, n, base);
 
-  // prevent crash if called with base == 1
-  if (base < 2) base = 10;
-
-  do {
-    char c = n % base;
-    n /= base;
-
-    *--str = c < 10 ? c + '0' : c + 'A' - 10;
-  } while(n);
-
-  return write(str);
+  return write(str, end - str);
 }
 
 size_t Print::printFloat(double number, uint8_t digits)
 {
+  // format into a buffer using fixed-point math for the fractional part
+  if (digits <= FMT_DOUBLE_MAX_DIGITS) {
+    char buf[FMT_DOUBLE_MAX_LEN];
+    return write(buf, fmt_double(buf, number, digits));
+  }
+
+  // fall back to one digit at a time for silly precisions
   size_t n = 0;
 
   if (isnan(number)) return print("nan");
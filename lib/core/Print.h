@@ -33,6 +33,9 @@
 #endif
 #define BIN 2
 
+// compile-time format string, see PrintFormat.h
+template<char... Cs> struct FormatString;
+
 class Print
 {
   private:
@@ -88,7 +91,14 @@ class Print
 
     size_t printf(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
 
+    // Type-checked printf with the format parsed at compile time, used as
+    // printf("value=%d\r\n"_fmt, value). Defined in PrintFormat.h
+    template<char... Cs, typename... Args>
+    size_t printf(const FormatString<Cs...> &fmt, Args... args);
+
     virtual void flush() { /* Empty implementation for backward compatibility */ }
 };
 
+#include "PrintFormat.h"
+
 #endif
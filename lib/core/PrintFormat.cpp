@@ -0,0 +1,201 @@
+/*******************************************************************************
+ * Compile-time parsed and type-checked format strings for Print::printf
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "Print.h"
+#include "fmtnum.h"
+
+namespace printformat {
+
+static size_t write_fill(Print &out, char c, size_t count)
+{
+    static const char spaces[] = "                ";
+    static const char zeros[]  = "0000000000000000";
+    const char *fill = (c == '0') ? zeros : spaces;
+
+    size_t n = 0;
+    while (count)
+    {
+        size_t chunk = count < sizeof(spaces) - 1 ? count : sizeof(spaces) - 1;
+        n += out.write(fill, chunk);
+        count -= chunk;
+    }
+    return n;
+}
+
+/*
+ * Write a formatted field: prefix (sign or 0x), then leading zeros, then body.
+ * Padding to width goes on the right for '-', between the prefix and body
+ * for '0', and otherwise on the left.
+ */
+static size_t write_field(Print &out, const char *prefix, size_t plen,
+                          const char *body, size_t blen, size_t zeros,
+                          uint8_t flags, uint8_t width)
+{
+    size_t total = plen + zeros + blen;
+    size_t pad = width > total ? width - total : 0;
+    size_t n = 0;
+
+    if (!(flags & (FLAG_LEFT | FLAG_ZERO)))
+        n += write_fill(out, ' ', pad);
+    if (plen)
+        n += out.write(prefix, plen);
+    if ((flags & (FLAG_LEFT | FLAG_ZERO)) == FLAG_ZERO)
+        zeros += pad;
+    n += write_fill(out, '0', zeros);
+    if (blen)
+        n += out.write(body, blen);
+    if (flags & FLAG_LEFT)
+        n += write_fill(out, ' ', pad);
+    return n;
+}
+
+// shared tail of print_signed and print_unsigned
+static size_t write_integer(Print &out, const char *prefix, size_t plen, const char *digits,
+                            size_t len, uint32_t value, uint8_t flags, uint8_t width, int8_t precision)
+{
+    size_t zeros = 0;
+    if (precision >= 0)
+    {
+        // as in printf, a precision means minimum digits and disables the 0 flag
+        flags &= ~FLAG_ZERO;
+        if (precision == 0 && value == 0)
+            len = 0;
+        if ((size_t)precision > len)
+            zeros = precision - len;
+    }
+    return write_field(out, prefix, plen, digits, len, zeros, flags, width);
+}
+
+size_t print_signed(Print &out, int32_t value, uint8_t flags, uint8_t width, int8_t precision)
+{
+    char buf[FMT_U32_MAX_LEN];
+    char *end = buf + sizeof(buf);
+    const char *prefix = "";
+    uint32_t mag = (uint32_t)value;
+
+    if (value < 0)
+    {
+        prefix = "-";
+        mag = 0u - mag;
+    }
+    else if (flags & FLAG_PLUS)
+        prefix = "+";
+    else if (flags & FLAG_SPACE)
+        prefix = " ";
+
+    char *digits = fmt_u32_dec(end, mag);
+    return write_integer(out, prefix, *prefix ? 1 : 0, digits, end - digits, mag, flags, width, precision);
+}
+
+size_t print_unsigned(Print &out, uint32_t value, char conv, uint8_t flags, uint8_t width, int8_t precision)
+{
+    char buf[FMT_U32_MAX_LEN];
+    char *end = buf + sizeof(buf);
+    char *digits;
+    const char *prefix = "";
+    size_t plen = 0;
+
+    // as in printf, # adds no prefix to 0, but %p always has one
+    switch (conv)
+    {
+        case 'p':
+            digits = fmt_u32_hex(end, value, false);
+            prefix = "0x";
+            plen = 2;
+            break;
+        case 'x':
+            digits = fmt_u32_hex(end, value, false);
+            if ((flags & FLAG_ALT) && value)
+            {
+                prefix = "0x";
+                plen = 2;
+            }
+            break;
+        case 'X':
+            digits = fmt_u32_hex(end, value, true);
+            if ((flags & FLAG_ALT) && value)
+            {
+                prefix = "0X";
+                plen = 2;
+            }
+            break;
+        case 'o':
+            digits = fmt_u32(end, value, 8);
+            if ((flags & FLAG_ALT) && value)
+            {
+                prefix = "0";
+                plen = 1;
+            }
+            break;
+        case 'b':
+            digits = fmt_u32(end, value, 2);
+            break;
+        default:
+            digits = fmt_u32_dec(end, value);
+            break;
+    }
+
+    return write_integer(out, prefix, plen, digits, end - digits, value, flags, width, precision);
+}
+
+size_t print_char(Print &out, char c, uint8_t flags, uint8_t width)
+{
+    return write_field(out, NULL, 0, &c, 1, 0, flags & ~FLAG_ZERO, width);
+}
+
+size_t print_string(Print &out, const char *s, uint8_t flags, uint8_t width, int8_t precision)
+{
+    if (s == NULL)
+        s = "(null)";
+
+    size_t len = 0;
+    while (s[len] != '\0' && (precision < 0 || len < (size_t)precision))
+        len++;
+
+    return write_field(out, NULL, 0, s, len, 0, flags & ~FLAG_ZERO, width);
+}
+
+size_t print_double(Print &out, double value, uint8_t flags, uint8_t width, int8_t precision)
+{
+    char buf[FMT_DOUBLE_MAX_LEN];
+    size_t len = fmt_double(buf, value, precision < 0 ? 6 : precision);
+    const char *body = buf;
+    const char *prefix = "";
+
+    if (buf[0] == '-')
+    {
+        prefix = "-";
+        body++;
+        len--;
+    }
+    else if (flags & FLAG_PLUS)
+        prefix = "+";
+    else if (flags & FLAG_SPACE)
+        prefix = " ";
+
+    // don't zero-pad nan, inf, or ovf
+    if (body[0] > '9')
+        flags &= ~FLAG_ZERO;
+
+    return write_field(out, prefix, *prefix ? 1 : 0, body, len, 0, flags, width);
+}
+
+} // namespace printformat
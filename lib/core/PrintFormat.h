@@ -0,0 +1,306 @@
+/*******************************************************************************
+ * Compile-time parsed and type-checked format strings for Print::printf
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+/*
+ * Usage: SerialUSB.printf("count=%u value=%-6d temp=%.2f\r\n"_fmt, n, v, t);
+ *
+ * The _fmt suffix (a GNU string literal operator template) turns the literal
+ * into a FormatString type, and the format is parsed by constexpr functions
+ * while compiling. Each call site becomes a fixed sequence of write() calls
+ * for the literal text plus one call to a small non-template helper per
+ * argument, so there's no runtime format parser, no varargs, and no heap
+ * allocation like the vasprintf-based printf.
+ *
+ * Wrong argument types or counts are compile errors (static_assert).
+ *
+ * Supported conversions: %d %i %u %x %X %o %b %c %s %p %f %F %%
+ * Flags: - 0 + space #, numeric width, and precision (minimum digits for
+ * integers, max length for %s, 0-9 fractional digits for %f, default 6).
+ * %f uses the same formatting as Print::print(double), so it rounds halves
+ * up, and values beyond +/-4294967040 print as "ovf".
+ * Length modifiers h, hh, l, z, t, and j are accepted and ignored since
+ * every integer is at most 32 bits. 64-bit integers (%ll) aren't supported.
+ */
+
+#ifndef PRINT_FORMAT_H
+#define PRINT_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+
+#include "Print.h"
+
+template<char... Cs>
+struct FormatString
+{
+    static constexpr char str[] = { Cs..., '\0' };
+    static constexpr size_t len = sizeof...(Cs);
+};
+
+template<char... Cs>
+constexpr char FormatString<Cs...>::str[];
+
+template<typename CharT, CharT... Cs>
+constexpr FormatString<Cs...> operator"" _fmt(void)
+{
+    static_assert(std::is_same<CharT, char>::value, "_fmt only works on narrow string literals");
+    return {};
+}
+
+namespace printformat {
+
+enum : uint8_t {
+    FLAG_LEFT   = 0x01, // '-'
+    FLAG_ZERO   = 0x02, // '0'
+    FLAG_PLUS   = 0x04, // '+'
+    FLAG_SPACE  = 0x08, // ' '
+    FLAG_ALT    = 0x10, // '#'
+    FLAG_LL     = 0x20, // 'll' length modifier, rejected with a static_assert
+    FLAG_BADLEN = 0x40, // 'L' or 'q' length modifier
+};
+
+struct Spec
+{
+    size_t end;         // index just past the conversion character
+    char conv;          // conversion character, or 0 if the spec is malformed
+    uint8_t flags;
+    uint8_t width;
+    int8_t precision;   // -1 if not specified
+};
+
+// index of the next '%' at or after pos, or the string length if none
+constexpr size_t find_percent(const char *s, size_t pos)
+{
+    while (s[pos] != '\0' && s[pos] != '%')
+        pos++;
+    return pos;
+}
+
+constexpr bool is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+// parse the conversion spec starting with the '%' at s[pos]
+constexpr Spec parse_spec(const char *s, size_t pos)
+{
+    Spec spec { 0, 0, 0, 0, -1 };
+    size_t i = pos + 1;
+
+    for (;; i++)
+    {
+        if (s[i] == '-')      spec.flags |= FLAG_LEFT;
+        else if (s[i] == '0') spec.flags |= FLAG_ZERO;
+        else if (s[i] == '+') spec.flags |= FLAG_PLUS;
+        else if (s[i] == ' ') spec.flags |= FLAG_SPACE;
+        else if (s[i] == '#') spec.flags |= FLAG_ALT;
+        else break;
+    }
+
+    unsigned width = 0;
+    while (is_digit(s[i]))
+        width = width * 10 + (s[i++] - '0');
+    spec.width = width > 255 ? 255 : width;
+
+    if (s[i] == '.')
+    {
+        unsigned precision = 0;
+        i++;
+        while (is_digit(s[i]))
+            precision = precision * 10 + (s[i++] - '0');
+        spec.precision = precision > 127 ? 127 : precision;
+    }
+
+    if (s[i] == 'l' && s[i+1] == 'l')
+    {
+        spec.flags |= FLAG_LL;
+        i += 2;
+    }
+    else if (s[i] == 'h' && s[i+1] == 'h')
+        i += 2;
+    else if (s[i] == 'h' || s[i] == 'l' || s[i] == 'z' || s[i] == 't' || s[i] == 'j')
+        i++;
+    else if (s[i] == 'L' || s[i] == 'q')
+    {
+        spec.flags |= FLAG_BADLEN;
+        i++;
+    }
+
+    switch (s[i])
+    {
+        case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'b':
+        case 'c': case 's': case 'p': case 'f': case 'F': case '%':
+            spec.conv = s[i];
+            spec.end = i + 1;
+            break;
+        default:
+            // unsupported or missing conversion, end stays at 0
+            break;
+    }
+    return spec;
+}
+
+constexpr bool is_int_conv(char c)
+{
+    return c == 'd' || c == 'i' || c == 'u' || c == 'x' || c == 'X' || c == 'o' || c == 'b' || c == 'c';
+}
+
+// Runtime helpers, in PrintFormat.cpp. These are shared by all call sites so
+// that each printf only adds a few instructions per argument.
+size_t print_signed(Print &out, int32_t value, uint8_t flags, uint8_t width, int8_t precision);
+size_t print_unsigned(Print &out, uint32_t value, char conv, uint8_t flags, uint8_t width, int8_t precision);
+size_t print_char(Print &out, char c, uint8_t flags, uint8_t width);
+size_t print_string(Print &out, const char *s, uint8_t flags, uint8_t width, int8_t precision);
+size_t print_double(Print &out, double value, uint8_t flags, uint8_t width, int8_t precision);
+
+// what to do at the next '%' (or the end of the string)
+enum class Step { End, Percent, Arg };
+
+template<Step S>
+using StepTag = std::integral_constant<Step, S>;
+
+template<typename T>
+using Decayed = typename std::decay<T>::type;
+
+// format a single argument, after type checks
+template<char Conv>
+using ConvTag = std::integral_constant<char, Conv>;
+
+template<typename T>
+inline size_t print_arg(Print &out, const Spec &spec, T value, ConvTag<'d'>)
+{
+    return print_signed(out, (int32_t)value, spec.flags, spec.width, spec.precision);
+}
+
+template<typename T>
+inline size_t print_arg(Print &out, const Spec &spec, T value, ConvTag<'i'>)
+{
+    return print_signed(out, (int32_t)value, spec.flags, spec.width, spec.precision);
+}
+
+template<typename T, char Conv>
+inline size_t print_arg(Print &out, const Spec &spec, T value, ConvTag<Conv>)
+{
+    // u x X o b
+    return print_unsigned(out, (uint32_t)value, Conv, spec.flags, spec.width, spec.precision);
+}
+
+template<typename T>
+inline size_t print_arg(Print &out, const Spec &spec, T value, ConvTag<'c'>)
+{
+    return print_char(out, (char)value, spec.flags, spec.width);
+}
+
+template<typename T>
+inline size_t print_arg(Print &out, const Spec &spec, T value, ConvTag<'s'>)
+{
+    return print_string(out, value, spec.flags, spec.width, spec.precision);
+}
+
+template<typename T>
+inline size_t print_arg(Print &out, const Spec &spec, T value, ConvTag<'p'>)
+{
+    return print_unsigned(out, (uint32_t)(uintptr_t)value, 'p', spec.flags, spec.width, spec.precision);
+}
+
+template<typename T>
+inline size_t print_arg(Print &out, const Spec &spec, T value, ConvTag<'f'>)
+{
+    return print_double(out, value, spec.flags, spec.width, spec.precision);
+}
+
+template<typename T>
+inline size_t print_arg(Print &out, const Spec &spec, T value, ConvTag<'F'>)
+{
+    return print_double(out, value, spec.flags, spec.width, spec.precision);
+}
+
+template<typename Fmt, size_t Pos, typename... Args>
+inline size_t emit(Print &out, Args... args);
+
+template<typename Fmt, size_t Pos, typename... Args>
+inline size_t emit_step(Print &, StepTag<Step::End>, Args...)
+{
+    static_assert(sizeof...(Args) == 0, "too many arguments for format string");
+    return 0;
+}
+
+template<typename Fmt, size_t Pos, typename... Args>
+inline size_t emit_step(Print &out, StepTag<Step::Percent>, Args... args)
+{
+    constexpr Spec spec = parse_spec(Fmt::str, Pos);
+    return out.write('%') + emit<Fmt, spec.end>(out, args...);
+}
+
+template<typename Fmt, size_t Pos>
+inline size_t emit_step(Print &, StepTag<Step::Arg>)
+{
+    static_assert(Pos != Pos, "too few arguments for format string");
+    return 0;
+}
+
+template<typename Fmt, size_t Pos, typename T, typename... Args>
+inline size_t emit_step(Print &out, StepTag<Step::Arg>, T value, Args... args)
+{
+    constexpr Spec spec = parse_spec(Fmt::str, Pos);
+    using A = Decayed<T>;
+
+    static_assert(!(spec.flags & FLAG_LL), "64-bit integers are not supported");
+    static_assert(!(spec.flags & FLAG_BADLEN), "unsupported length modifier");
+
+    static_assert(!is_int_conv(spec.conv) || std::is_integral<A>::value || std::is_enum<A>::value,
+                  "format expects an integer argument");
+    static_assert(!is_int_conv(spec.conv) || !std::is_integral<A>::value || sizeof(A) <= 4,
+                  "64-bit integers are not supported");
+    static_assert(!(spec.conv == 'f' || spec.conv == 'F') || std::is_floating_point<A>::value,
+                  "format expects a floating-point argument");
+    static_assert(!(spec.conv == 'f' || spec.conv == 'F') || spec.precision <= 9,
+                  "at most 9 digits after the decimal point are supported");
+    static_assert(spec.conv != 's' || std::is_convertible<A, const char *>::value,
+                  "format expects a string argument");
+    static_assert(spec.conv != 'p' || std::is_pointer<A>::value, "format expects a pointer argument");
+
+    return print_arg(out, spec, (A)value, ConvTag<spec.conv>()) + emit<Fmt, spec.end>(out, args...);
+}
+
+template<typename Fmt, size_t Pos, typename... Args>
+inline size_t emit(Print &out, Args... args)
+{
+    constexpr size_t pct = find_percent(Fmt::str, Pos);
+    constexpr Step step = (pct == Fmt::len) ? Step::End :
+                          (parse_spec(Fmt::str, pct).conv == '%') ? Step::Percent : Step::Arg;
+    static_assert(step == Step::End || parse_spec(Fmt::str, pct).conv != 0,
+                  "invalid or unsupported conversion in format string");
+
+    size_t n = 0;
+    if (pct != Pos)
+        n = out.write(Fmt::str + Pos, pct - Pos);
+    return n + emit_step<Fmt, pct>(out, StepTag<step>(), args...);
+}
+
+} // namespace printformat
+
+template<char... Cs, typename... Args>
+inline size_t Print::printf(const FormatString<Cs...> &, Args... args)
+{
+    return printformat::emit<FormatString<Cs...>, 0>(*this, args...);
+}
+
+#endif // PRINT_FORMAT_H
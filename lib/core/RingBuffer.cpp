@@ -18,6 +18,7 @@
 
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
 
 #include "RingBuffer.h"
 
@@ -129,6 +130,28 @@ int RingBuffer::read_char(void)
   return value;
 }
 
+// Copy up to len bytes out of the buffer, in at most two contiguous chunks.
+// Like read_char, this is safe with a concurrent store_char in an ISR.
+size_t RingBuffer::read_chars(uint8_t *buf, size_t len)
+{
+  size_t count = 0;
+  int tail = _iTail;
+  const int head = _iHead;
+
+  while (count < len && tail != head) {
+    // contiguous bytes up to the head or the end of the buffer
+    size_t chunk = (head > tail ? head : (int)size) - tail;
+    if (chunk > len - count)
+      chunk = len - count;
+    memcpy(buf + count, _aucBuffer + tail, chunk);
+    count += chunk;
+    tail = (tail + chunk) & (size - 1);
+  }
+
+  _iTail = tail;
+  return count;
+}
+
 int RingBuffer::available(void)
 {
   int delta = _iHead - _iTail;
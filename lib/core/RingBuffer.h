@@ -19,6 +19,7 @@
 #ifndef RING_BUFFER_H
 #define RING_BUFFER_H
 
+#include <cstddef>
 #include <cstdint>
 
 // Define constants and variables for buffering incoming serial data.  We're
@@ -40,6 +41,7 @@ class RingBuffer
     void store_char(uint8_t c);
     void clear(void);
     int read_char(void);
+    size_t read_chars(uint8_t *buf, size_t len);
     int available(void);
     int availableForStore(void);
     int peek(void);
@@ -263,6 +263,8 @@ String Stream::readStringUntil(char terminator)
  *
  * The string in buf will always be null-terminated.
  * Returns the number of characters read (not including the CR or the nullbyte)
+ *
+ * This blocks until a CR is received, LineReader is a non-blocking alternative.
  */
 size_t Stream::readLine(char *buf, size_t bufsize, bool echo)
 {
@@ -300,6 +302,18 @@ size_t Stream::readLine(char *buf, size_t bufsize, bool echo)
   return count;
 }
 
+size_t Stream::readAvailable(uint8_t *buffer, size_t length)
+{
+  size_t count = 0;
+  while (count < length && available() > 0) {
+    int c = read();
+    if (c < 0)
+      break;
+    buffer[count++] = (uint8_t)c;
+  }
+  return count;
+}
+
 int Stream::findMulti( struct Stream::MultiTarget *targets, int tCount) {
   // any zero length target string automatically matches and would make
   // a mess of the rest of the algorithm.
@@ -108,6 +108,11 @@ class Stream : public Print
   String readStringUntil(char terminator);
   size_t readLine(char *buf, size_t bufsize, bool echo=false);
 
+  // Non-blocking bulk read: copy up to length bytes which are already available
+  // into buffer and return how many were copied (possibly 0). The default uses
+  // available() and read(), buffered streams override it to copy in bulk.
+  virtual size_t readAvailable(uint8_t *buffer, size_t length);
+
   protected:
   long parseInt(char ignore) { return parseInt(SKIP_ALL, ignore); }
   float parseFloat(char ignore) { return parseFloat(SKIP_ALL, ignore); }
@@ -0,0 +1,137 @@
+/*******************************************************************************
+ * Timestamped trace event ring buffer
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include "Arduino.h"
+#include "Trace.h"
+
+static_assert((TRACE_BUFFER_EVENTS & (TRACE_BUFFER_EVENTS - 1)) == 0,
+              "TRACE_BUFFER_EVENTS must be a power of 2");
+static_assert(VARIANT_MCK / 1000 <= 65536, "SysTick cycles per ms don't fit in 16 bits");
+
+struct TraceEvent {
+    uint32_t ms;        // millis() tick
+    uint16_t cycles;    // SysTick cycles since the tick, LOAD - VAL
+    uint16_t id_type;   // ID in bits 0-13, type in bits 14-15
+};
+
+static TraceEvent trace_buf[TRACE_BUFFER_EVENTS];
+static uint32_t trace_count = 0;    // total events recorded, the head is this mod the size
+static uint32_t trace_dropped = 0;  // events discarded during trace_dump
+static bool trace_paused = false;
+
+static struct {
+    uint16_t id;
+    const char *name;
+} trace_names[TRACE_MAX_NAMES];
+static unsigned int trace_num_names = 0;
+
+void trace_record(uint16_t id, uint8_t type)
+{
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (trace_paused)
+    {
+        trace_dropped++;
+        __set_PRIMASK(primask);
+        return;
+    }
+
+    // The tick can't advance with interrupts disabled, but SysTick may have
+    // wrapped and be waiting to run. If so, count that tick and re-read VAL
+    // in case the wrap happened after the first read.
+    uint32_t ms = millis();
+    uint32_t val = SysTick->VAL;
+    if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk)
+    {
+        ms++;
+        val = SysTick->VAL;
+    }
+
+    TraceEvent *ev = &trace_buf[trace_count & (TRACE_BUFFER_EVENTS - 1)];
+    ev->ms = ms;
+    ev->cycles = (uint16_t)(SysTick->LOAD - val);
+    ev->id_type = (uint16_t)((id & TRACE_ID_MAX) | (type << 14));
+    trace_count++;
+
+    __set_PRIMASK(primask);
+}
+
+bool trace_name(uint16_t id, const char *name)
+{
+    for (unsigned int i = 0; i < trace_num_names; i++)
+    {
+        if (trace_names[i].id == id)
+        {
+            trace_names[i].name = name;
+            return true;
+        }
+    }
+
+    if (trace_num_names >= TRACE_MAX_NAMES)
+        return false;
+    trace_names[trace_num_names].id = id;
+    trace_names[trace_num_names].name = name;
+    trace_num_names++;
+    return true;
+}
+
+void trace_clear(void)
+{
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    trace_count = 0;
+    trace_dropped = 0;
+    __set_PRIMASK(primask);
+}
+
+void trace_dump(Print &out, bool clear)
+{
+    static const char type_chars[] = { 'B', 'E', 'I', '?' };
+
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    trace_paused = true;
+    const uint32_t count = trace_count;
+    __set_PRIMASK(primask);
+
+    const uint32_t n = count < TRACE_BUFFER_EVENTS ? count : TRACE_BUFFER_EVENTS;
+    out.printf("# trace f_cpu=%u events=%u overwritten=%u dropped=%u\r\n"_fmt,
+               (unsigned)VARIANT_MCK, (unsigned)n, (unsigned)(count - n), (unsigned)trace_dropped);
+
+    for (unsigned int i = 0; i < trace_num_names; i++)
+        out.printf("N %u %s\r\n"_fmt, trace_names[i].id, trace_names[i].name);
+
+    for (uint32_t i = count - n; i != count; i++)
+    {
+        const TraceEvent *ev = &trace_buf[i & (TRACE_BUFFER_EVENTS - 1)];
+        out.printf("%u %u %c %u\r\n"_fmt, (unsigned)ev->ms, ev->cycles,
+                   type_chars[ev->id_type >> 14], ev->id_type & TRACE_ID_MAX);
+    }
+    out.print("# end\r\n");
+
+    __disable_irq();
+    if (clear)
+    {
+        trace_count = 0;
+        trace_dropped = 0;
+    }
+    trace_paused = false;
+    __set_PRIMASK(primask);
+}
@@ -0,0 +1,105 @@
+/*******************************************************************************
+ * Timestamped trace event ring buffer
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+/*
+ * Records begin/end/instant events with a numeric ID and a CPU cycle
+ * timestamp (the millis() tick plus the SysTick count within it) in a RAM
+ * ring, keeping the newest TRACE_BUFFER_EVENTS. Recording is a short critical
+ * section, so it's fine to use from interrupt handlers.
+ *
+ *   TRACE_NAME(1, "adc_isr");
+ *   ...
+ *   TRACE_BEGIN(1);
+ *   ...
+ *   TRACE_END(1);
+ *   ...
+ *   trace_dump(SerialUSB);
+ *
+ * The TRACE_* macros compile to nothing unless TRACE_ENABLE is defined, e.g.
+ * in a sketch's config.mk. scripts/trace2chrome.py converts the dump to
+ * Chrome trace JSON for chrome://tracing or Perfetto.
+ *
+ * With DELAY_SLEEP_SUPPRESS_SYSTICK the tick is stopped during long sleeps, so
+ * events from interrupts that wake the CPU get the time the sleep began.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// number of events kept, must be a power of 2. Each event is 8 bytes.
+#ifndef TRACE_BUFFER_EVENTS
+#define TRACE_BUFFER_EVENTS 256
+#endif
+
+// number of IDs which can be given names with trace_name()
+#ifndef TRACE_MAX_NAMES
+#define TRACE_MAX_NAMES 16
+#endif
+
+// IDs are 14 bits, the top 2 bits of the event word hold the type
+#define TRACE_ID_MAX 0x3fff
+
+#define TRACE_TYPE_BEGIN    0
+#define TRACE_TYPE_END      1
+#define TRACE_TYPE_INSTANT  2
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void trace_record(uint16_t id, uint8_t type);
+
+// Name an ID in the dump. The string isn't copied. Returns false if the name
+// table is full.
+bool trace_name(uint16_t id, const char *name);
+
+// Discard all recorded events
+void trace_clear(void);
+
+#ifdef __cplusplus
+} // extern "C"
+
+#include "Print.h"
+
+// Print the recorded events, oldest first, and optionally clear them. Events
+// recorded while dumping are dropped and counted, since printing can take a
+// while. The output is line based:
+//   # trace f_cpu=<hz> events=<n> overwritten=<n> dropped=<n>
+//   N <id> <name>                  for each named ID
+//   <ms> <cycles> <B|E|I> <id>     for each event
+//   # end
+void trace_dump(Print &out, bool clear=true);
+#endif
+
+#ifdef TRACE_ENABLE
+#define TRACE_BEGIN(id)         trace_record((id), TRACE_TYPE_BEGIN)
+#define TRACE_END(id)           trace_record((id), TRACE_TYPE_END)
+#define TRACE_INSTANT(id)       trace_record((id), TRACE_TYPE_INSTANT)
+#define TRACE_NAME(id, name)    trace_name((id), (name))
+#else
+#define TRACE_BEGIN(id)         do { } while (0)
+#define TRACE_END(id)           do { } while (0)
+#define TRACE_INSTANT(id)       do { } while (0)
+#define TRACE_NAME(id, name)    do { } while (0)
+#endif
+
+#endif // TRACE_H
@@ -203,6 +203,23 @@ size_t Serial_::readBytes(char *buffer, size_t length)
 	return count;
 }
 
+size_t Serial_::readAvailable(uint8_t *buffer, size_t length)
+{
+	size_t count = 0;
+	if (length && _serialPeek != -1) {
+		buffer[count++] = (uint8_t)_serialPeek;
+		_serialPeek = -1;
+	}
+
+	if (count < length) {
+		// recv is non-blocking, and returns -1 if USB isn't configured
+		uint32_t n = usb.recv(CDC_ENDPOINT_OUT, buffer+count, length-count);
+		if (n != (uint32_t)-1)
+			count += n;
+	}
+	return count;
+}
+
 void Serial_::flush(void)
 {
 	usb.flush(CDC_ENDPOINT_IN);
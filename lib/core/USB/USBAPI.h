@@ -131,6 +131,7 @@ public:
 	operator bool();
 
 	size_t readBytes(char *buffer, size_t length);
+	size_t readAvailable(uint8_t *buffer, size_t length);
 
 	// This method allows processing "SEND_BREAK" requests sent by
 	// the USB host. Those requests indicate that the host wants to
@@ -155,6 +155,20 @@ int Uart::read()
   return c;
 }
 
+size_t Uart::readAvailable(uint8_t *buffer, size_t length)
+{
+  size_t count = rxBuffer.read_chars(buffer, length);
+
+  if (uc_pinRTS != NO_RTS_PIN) {
+    // if there is enough space in the RX buffer, assert RTS
+    if (rxBuffer.availableForStore() > RTS_RX_THRESHOLD) {
+      *pul_outclrRTS = ul_pinMaskRTS;
+    }
+  }
+
+  return count;
+}
+
 size_t Uart::write(const uint8_t data)
 {
   if (sercom->isDataRegisterEmptyUART() && txBuffer.available() == 0) {
@@ -36,6 +36,7 @@ class Uart : public HardwareSerial
     int availableForWrite();
     int peek();
     int read();
+    size_t readAvailable(uint8_t *buffer, size_t length);
     void flush();
     size_t write(const uint8_t data);
     using Print::write; // pull in write(str) and write(buf, size) from Print
@@ -19,19 +19,55 @@
 #include "Arduino.h"
 #include "wiring_private.h"
 
-#include <string.h>
+/*
+ * Callbacks indexed by EXTINT number, so EIC_Handler finds each pending line's
+ * callback directly instead of searching a list. Unused lines point to
+ * nopCallback so the handler never needs a NULL check.
+ */
+typedef struct {
+  extIntFuncPtr callback;
+  void *ctx;
+} ExtIntEntry;
+
+static ExtIntEntry ISRtable[EXTERNAL_NUM_INTERRUPTS];
+static int         enabled = 0;
 
-static voidFuncPtr ISRcallback[EXTERNAL_NUM_INTERRUPTS];
-static uint32_t    ISRlist[EXTERNAL_NUM_INTERRUPTS];
-static uint32_t    nints; // Stores total number of attached interrupts
 
+static void nopCallback(uint32_t extint, void *ctx)
+{
+  (void)extint;
+  (void)ctx;
+}
+
+// attachInterrupt() callbacks don't take arguments, the function is the ctx
+static void voidCallback(uint32_t extint, void *ctx)
+{
+  (void)extint;
+  ((voidFuncPtr)ctx)();
+}
+
+/*
+ * Index of the lowest set bit of a non-zero x. The M0+ has no CLZ/CTZ
+ * instruction, so isolate the bit and multiply by a de Bruijn sequence, which
+ * puts a unique 5-bit pattern in the top bits for each bit position.
+ */
+static const uint8_t debruijnBitPos[32] = {
+   0,  1, 28,  2, 29, 14, 24,  3, 30, 22, 20, 15, 25, 17,  4,  8,
+  31, 27, 13, 23, 21, 19, 16,  7, 26, 12, 18,  6, 11,  5, 10,  9,
+};
+
+static inline uint32_t lowestBit(uint32_t x)
+{
+  return debruijnBitPos[((x & -x) * 0x077CB531u) >> 27];
+}
 
 /* Configure I/O interrupt sources */
 static void __initialize()
 {
-  memset(ISRlist,     0, sizeof(ISRlist));
-  memset(ISRcallback, 0, sizeof(ISRcallback));
-  nints = 0;
+  for (uint32_t i = 0; i < EXTERNAL_NUM_INTERRUPTS; i++) {
+    ISRtable[i].callback = nopCallback;
+    ISRtable[i].ctx = NULL;
+  }
 
   NVIC_DisableIRQ(EIC_IRQn);
   NVIC_ClearPendingIRQ(EIC_IRQn);
@@ -52,16 +88,53 @@ static void __initialize()
   while (EIC->STATUS.bit.SYNCBUSY == 1) { }
 }
 
-/*
- * \brief Specifies a named Interrupt Service Routine (ISR) to call when an interrupt occurs.
- *        Replaces any previous function that was attached to the interrupt.
- */
-void attachInterrupt(uint32_t pin, voidFuncPtr callback, uint32_t mode)
+/* Set the sense mode (LOW, HIGH, CHANGE, FALLING, RISING) of an EXTINT line */
+static void __setSense(EExt_Interrupts in, uint32_t mode)
 {
-  static int enabled = 0;
   uint32_t config;
   uint32_t pos;
 
+  // Look for right CONFIG register to be addressed
+  if (in > EXTERNAL_INT_7) {
+    config = 1;
+    pos = (in - 8) << 2;
+  } else {
+    config = 0;
+    pos = in << 2;
+  }
+
+  // Configure the interrupt mode
+  EIC->CONFIG[config].reg &=~ (EIC_CONFIG_SENSE0_Msk << pos); // Reset sense mode, important when changing trigger mode during runtime
+  switch (mode)
+  {
+    case LOW:
+      EIC->CONFIG[config].reg |= EIC_CONFIG_SENSE0_LOW_Val << pos;
+      break;
+
+    case HIGH:
+      EIC->CONFIG[config].reg |= EIC_CONFIG_SENSE0_HIGH_Val << pos;
+      break;
+
+    case CHANGE:
+      EIC->CONFIG[config].reg |= EIC_CONFIG_SENSE0_BOTH_Val << pos;
+      break;
+
+    case FALLING:
+      EIC->CONFIG[config].reg |= EIC_CONFIG_SENSE0_FALL_Val << pos;
+      break;
+
+    case RISING:
+      EIC->CONFIG[config].reg |= EIC_CONFIG_SENSE0_RISE_Val << pos;
+      break;
+  }
+}
+
+/*
+ * \brief Specifies a function to call with the EXTINT number and ctx when an interrupt occurs.
+ *        Replaces any previous function that was attached to the interrupt.
+ */
+void attachInterruptArg(uint32_t pin, extIntFuncPtr callback, void *ctx, uint32_t mode)
+{
 #if ARDUINO_SAMD_VARIANT_COMPLIANCE >= 10606
   EExt_Interrupts in = g_APinDescription[pin].ulExtInt;
 #else
@@ -75,73 +148,49 @@ void attachInterrupt(uint32_t pin, voidFuncPtr callback, uint32_t mode)
     enabled = 1;
   }
 
-  // Enable wakeup capability on pin in case being used during sleep
+  // Mask the line while its table entry changes, so the handler never sees a
+  // callback with the wrong ctx
   uint32_t inMask = 1 << in;
+  EIC->INTENCLR.reg = EIC_INTENCLR_EXTINT(inMask);
+
+  // Stop any events from an earlier attachInterruptEvent() on this line
+  EIC->EVCTRL.reg &= ~EIC_EVCTRL_EXTINTEO(inMask);
+
+  // Enable wakeup capability on pin in case being used during sleep
   EIC->WAKEUP.reg |= inMask;
 
   // Assign pin to EIC
   pinPeripheral(pin, PIO_EXTINT);
 
-  // Only store when there is really an ISR to call.
-  // This allow for calling attachInterrupt(pin, NULL, mode), we set up all needed register
-  // but won't service the interrupt, this way we also don't need to check it inside the ISR.
+  // A NULL callback sets up all the registers but doesn't service the
+  // interrupt, the handler only clears its flag.
   if (callback)
   {
-    // Store interrupts to service in order of when they were attached
-    // to allow for first come first serve handler
-    uint32_t current = 0;
-
-    // Check if we already have this interrupt
-    for (current=0; current<nints; current++) {
-      if (ISRlist[current] == inMask) {
-        break;
-      }
-    }
-    if (current == nints) {
-      // Need to make a new entry
-      nints++;
-    }
-    ISRlist[current] = inMask;       // List of interrupt in order of when they were attached
-    ISRcallback[current] = callback; // List of callback adresses
-
-    // Look for right CONFIG register to be addressed
-    if (in > EXTERNAL_INT_7) {
-      config = 1;
-      pos = (in - 8) << 2;
-    } else {
-      config = 0;
-      pos = in << 2;
-    }
+    ISRtable[in].callback = callback;
+    ISRtable[in].ctx = ctx;
 
     // Configure the interrupt mode
-    EIC->CONFIG[config].reg &=~ (EIC_CONFIG_SENSE0_Msk << pos); // Reset sense mode, important when changing trigger mode during runtime
-    switch (mode)
-    {
-      case LOW:
-        EIC->CONFIG[config].reg |= EIC_CONFIG_SENSE0_LOW_Val << pos;
-        break;
-
-      case HIGH:
-        EIC->CONFIG[config].reg |= EIC_CONFIG_SENSE0_HIGH_Val << pos;
-        break;
-
-      case CHANGE:
-        EIC->CONFIG[config].reg |= EIC_CONFIG_SENSE0_BOTH_Val << pos;
-        break;
-
-      case FALLING:
-        EIC->CONFIG[config].reg |= EIC_CONFIG_SENSE0_FALL_Val << pos;
-        break;
-
-      case RISING:
-        EIC->CONFIG[config].reg |= EIC_CONFIG_SENSE0_RISE_Val << pos;
-        break;
-    }
+    __setSense(in, mode);
   }
+  else
+  {
+    ISRtable[in].callback = nopCallback;
+    ISRtable[in].ctx = NULL;
+  }
+
   // Enable the interrupt
   EIC->INTENSET.reg = EIC_INTENSET_EXTINT(inMask);
 }
 
+/*
+ * \brief Specifies a named Interrupt Service Routine (ISR) to call when an interrupt occurs.
+ *        Replaces any previous function that was attached to the interrupt.
+ */
+void attachInterrupt(uint32_t pin, voidFuncPtr callback, uint32_t mode)
+{
+  attachInterruptArg(pin, callback ? voidCallback : NULL, (void*)callback, mode);
+}
+
 /*
  * \brief Turns off the given interrupt.
  */
@@ -157,25 +206,45 @@ void detachInterrupt(uint32_t pin)
 
   uint32_t inMask = 1 << in;
   EIC->INTENCLR.reg = EIC_INTENCLR_EXTINT(inMask);
-  
+
+  // Stop events too, if the line was set up with attachInterruptEvent()
+  EIC->EVCTRL.reg &= ~EIC_EVCTRL_EXTINTEO(inMask);
+
   // Disable wakeup capability on pin during sleep
   EIC->WAKEUP.reg &= ~inMask;
 
-  // Remove callback from the ISR list
-  uint32_t current;
-  for (current=0; current<nints; current++) {
-    if (ISRlist[current] == inMask) {
-      break;
-    }
-  }
-  if (current == nints) return; // We didn't have it
+  ISRtable[in].callback = nopCallback;
+  ISRtable[in].ctx = NULL;
+}
+
+/*
+ * \brief Generate events from a pin's EXTINT line instead of interrupts.
+ *        The EXTINT interrupt is masked. attachInterrupt() or detachInterrupt() on
+ *        the same line turns the events off again.
+ */
+int attachInterruptEvent(uint32_t pin, uint32_t mode)
+{
+#if ARDUINO_SAMD_VARIANT_COMPLIANCE >= 10606
+  EExt_Interrupts in = g_APinDescription[pin].ulExtInt;
+#else
+  EExt_Interrupts in = digitalPinToInterrupt(pin);
+#endif
+  if (in == NOT_AN_INTERRUPT || in == EXTERNAL_INT_NMI)
+    return -1;
 
-  // Shift the reminder down
-  for (; current<nints-1; current++) {
-    ISRlist[current]     = ISRlist[current+1];
-    ISRcallback[current] = ISRcallback[current+1];
+  if (!enabled) {
+    __initialize();
+    enabled = 1;
   }
-  nints--;
+
+  uint32_t inMask = 1 << in;
+  EIC->INTENCLR.reg = EIC_INTENCLR_EXTINT(inMask);
+
+  pinPeripheral(pin, PIO_EXTINT);
+  __setSense(in, mode);
+  EIC->EVCTRL.reg |= EIC_EVCTRL_EXTINTEO(inMask);
+
+  return in;
 }
 
 /*
@@ -183,19 +252,19 @@ void detachInterrupt(uint32_t pin)
  */
 void EIC_Handler(void)
 {
-  // Calling the routine directly from -here- takes about 1us
-  // Depending on where you are in the list it will take longer
-
-  // Loop over all enabled interrupts in the list
-  for (uint32_t i=0; i<nints; i++)
+  // Service every pending line that has its interrupt enabled, lowest EXTINT
+  // first. The cost per line is the same no matter how many are attached.
+  uint32_t flags = EIC->INTFLAG.reg & EIC->INTENSET.reg;
+  while (flags)
   {
-    if ((EIC->INTFLAG.reg & ISRlist[i]) != 0)
-    {
-      // Call the callback function
-      ISRcallback[i]();
-      // Clear the interrupt
-      EIC->INTFLAG.reg = ISRlist[i];
-    }
+    uint32_t in = lowestBit(flags);
+    uint32_t inMask = 1ul << in;
+    flags &= ~inMask;
+
+    // Clear the flag first, so an edge during the callback pends the
+    // interrupt again rather than being lost
+    EIC->INTFLAG.reg = inMask;
+    ISRtable[in].callback(in, ISRtable[in].ctx);
   }
 }
 
@@ -36,6 +36,7 @@ extern "C" {
 #define EXTERNAL 0
 
 typedef void (*voidFuncPtr)(void);
+typedef void (*extIntFuncPtr)(uint32_t extint, void *ctx);
 
 /*
  * \brief Specifies a named Interrupt Service Routine (ISR) to call when an interrupt occurs.
@@ -44,10 +45,23 @@ typedef void (*voidFuncPtr)(void);
 void attachInterrupt(uint32_t pin, voidFuncPtr callback, uint32_t mode);
 
 /*
- * \brief Turns off the given interrupt.
+ * \brief Like attachInterrupt(), but the callback is passed the pin's EXTINT number and ctx,
+ *        so one function can serve several pins or object instances.
+ */
+void attachInterruptArg(uint32_t pin, extIntFuncPtr callback, void *ctx, uint32_t mode);
+
+/*
+ * \brief Turns off the given interrupt, or the events from attachInterruptEvent().
  */
 void detachInterrupt(uint32_t pin);
 
+/*
+ * \brief Configure the pin's EXTINT line to output EIC events rather than interrupts.
+ *        Returns the EXTINT number (EVSYS generator EVSYS_ID_GEN_EIC_EXTINT_0 + n) or -1.
+ *        attachInterrupt() or detachInterrupt() on the pin turns the events off.
+ */
+int attachInterruptEvent(uint32_t pin, uint32_t mode);
+
 /*
  * \brief enable or disable majority vote filter
  */
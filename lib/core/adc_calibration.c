@@ -0,0 +1,228 @@
+/*******************************************************************************
+ * ADC offset and gain calibration, stored in the last row of flash
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include "Arduino.h"
+#include "wiring_private.h"
+#include "adc_calibration.h"
+
+#define CAL_MAGIC 0x43434441ul  // "ADCC"
+
+#define CAL_TOP_VALUE       4095
+#define CAL_MAX_OFFSET      2047
+#define CAL_MIN_GAIN        0x400
+#define CAL_MAX_GAIN        0xfff
+
+typedef struct {
+    uint32_t magic;
+    AdcCalibration cal;
+    uint32_t check;     // ~(magic ^ cal), catches a half-written record
+} CalRecord;
+
+static inline void adc_sync(void)
+{
+    while (ADC->STATUS.bit.SYNCBUSY);
+}
+
+static inline uint32_t cal_check(const CalRecord *rec)
+{
+    uint32_t cal;
+    memcpy(&cal, &rec->cal, sizeof(cal));
+    return ~(rec->magic ^ cal);
+}
+
+void adc_calibration_apply(const AdcCalibration *cal)
+{
+    adc_sync();
+    ADC->OFFSETCORR.reg = ADC_OFFSETCORR_OFFSETCORR(cal->offset);
+    adc_sync();
+    ADC->GAINCORR.reg = ADC_GAINCORR_GAINCORR(cal->gain);
+    adc_sync();
+    ADC->CTRLB.reg |= ADC_CTRLB_CORREN;
+    adc_sync();
+}
+
+bool adc_calibration_load(void)
+{
+    const CalRecord *rec = (const CalRecord*)ADC_CALIBRATION_ADDR;
+    if (rec->magic != CAL_MAGIC || rec->check != cal_check(rec))
+        return false;
+    adc_calibration_apply(&rec->cal);
+    return true;
+}
+
+// One averaged reading of the current MUXPOS
+static uint32_t cal_read(void)
+{
+    ADC->INTFLAG.reg = ADC_INTFLAG_RESRDY;
+    adc_sync();
+    ADC->SWTRIG.reg = ADC_SWTRIG_START;
+    while (!ADC->INTFLAG.bit.RESRDY);
+    return ADC->RESULT.reg;
+}
+
+static void cal_select(uint32_t pin)
+{
+    adc_sync();
+    ADC->INPUTCTRL.bit.MUXPOS = g_APinDescription[pin].ulADCChannelNumber;
+    cal_read();     // let the input settle
+}
+
+static void cal_set(int32_t offset, uint32_t gain)
+{
+    adc_sync();
+    ADC->OFFSETCORR.reg = ADC_OFFSETCORR_OFFSETCORR(offset);
+    adc_sync();
+    ADC->GAINCORR.reg = ADC_GAINCORR_GAINCORR(gain);
+    adc_sync();
+}
+
+// Full scale, or wrapped around past it
+static inline bool cal_is_top(uint32_t value)
+{
+    return value >= CAL_TOP_VALUE || value < CAL_TOP_VALUE / 2;
+}
+
+bool adc_calibrate(uint32_t gnd_pin, uint32_t top_pin, AdcCalibration *cal)
+{
+    adc_sync();
+    const uint32_t enabled = ADC->CTRLA.reg & ADC_CTRLA_ENABLE;
+    const uint16_t ctrlb = ADC->CTRLB.reg;
+    const uint8_t avgctrl = ADC->AVGCTRL.reg;
+    const uint32_t inputctrl = ADC->INPUTCTRL.reg;
+    const uint16_t offsetcorr = ADC->OFFSETCORR.reg;
+    const uint16_t gaincorr = ADC->GAINCORR.reg;
+
+    pinPeripheral(gnd_pin, PIO_ANALOG);
+    pinPeripheral(top_pin, PIO_ANALOG);
+
+    // 1.5MHz ADC clock, 16 samples accumulated and shifted back to 12 bits
+    ADC->CTRLA.reg &= ~ADC_CTRLA_ENABLE;
+    adc_sync();
+    ADC->CTRLB.reg = ADC_CTRLB_PRESCALER_DIV32 | ADC_CTRLB_RESSEL_16BIT | ADC_CTRLB_CORREN;
+    adc_sync();
+    ADC->AVGCTRL.reg = ADC_AVGCTRL_SAMPLENUM_16 | ADC_AVGCTRL_ADJRES(4);
+    adc_sync();
+    ADC->CTRLA.reg |= ADC_CTRLA_ENABLE;
+    adc_sync();
+
+    // GND reads less as the offset goes up, until it sticks at 0
+    bool ok = true;
+    cal_select(gnd_pin);
+    cal_set(CAL_MAX_OFFSET, ADC_GAINCORR_UNITY);
+    if (cal_read() != 0)
+        ok = false;
+
+    uint32_t lo = 0, hi = CAL_MAX_OFFSET;
+    while (ok && lo < hi)
+    {
+        const uint32_t mid = (lo + hi) / 2;
+        cal_set(mid, ADC_GAINCORR_UNITY);
+        if (cal_read() == 0)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    const int32_t offset = lo;
+
+    // with that offset, the top reads more as the gain goes up, until full scale
+    cal_select(top_pin);
+    cal_set(offset, CAL_MAX_GAIN);
+    if (ok && !cal_is_top(cal_read()))
+        ok = false;
+
+    lo = CAL_MIN_GAIN;
+    hi = CAL_MAX_GAIN;
+    while (ok && lo < hi)
+    {
+        const uint32_t mid = (lo + hi) / 2;
+        cal_set(offset, mid);
+        if (cal_is_top(cal_read()))
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+
+    ADC->CTRLA.reg &= ~ADC_CTRLA_ENABLE;
+    adc_sync();
+    ADC->CTRLB.reg = ctrlb;
+    adc_sync();
+    ADC->AVGCTRL.reg = avgctrl;
+    adc_sync();
+    ADC->INPUTCTRL.reg = inputctrl;
+    adc_sync();
+    ADC->OFFSETCORR.reg = offsetcorr;
+    adc_sync();
+    ADC->GAINCORR.reg = gaincorr;
+    adc_sync();
+    ADC->CTRLA.reg |= enabled;
+    adc_sync();
+
+    if (ok)
+    {
+        cal->offset = offset;
+        cal->gain = lo;
+        adc_calibration_apply(cal);
+    }
+    analogReadInvalidate();
+    return ok;
+}
+
+static bool nvm_command(uint32_t cmd)
+{
+    while (!(NVMCTRL->INTFLAG.reg & NVMCTRL_INTFLAG_READY));
+    NVMCTRL->STATUS.reg = NVMCTRL_STATUS_MASK;
+    NVMCTRL->ADDR.reg = ADC_CALIBRATION_ADDR / 2;   // 16-bit word address
+    NVMCTRL->CTRLA.reg = cmd | NVMCTRL_CTRLA_CMDEX_KEY;
+    while (!(NVMCTRL->INTFLAG.reg & NVMCTRL_INTFLAG_READY));
+    return !(NVMCTRL->STATUS.reg & (NVMCTRL_STATUS_PROGE | NVMCTRL_STATUS_LOCKE | NVMCTRL_STATUS_NVME));
+}
+
+bool adc_calibration_erase(void)
+{
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    const bool ok = nvm_command(NVMCTRL_CTRLA_CMD_ER) && nvm_command(NVMCTRL_CTRLA_CMD_INVALL);
+    __set_PRIMASK(primask);
+    return ok;
+}
+
+bool adc_calibration_store(const AdcCalibration *cal)
+{
+    CalRecord rec;
+    rec.magic = CAL_MAGIC;
+    rec.cal = *cal;
+    rec.check = cal_check(&rec);
+
+    // startup sets MANW, so the page buffer is only written by the WP command
+    const uint32_t *src = (const uint32_t*)&rec;
+    volatile uint32_t *dst = (volatile uint32_t*)ADC_CALIBRATION_ADDR;
+
+    const uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    bool ok = nvm_command(NVMCTRL_CTRLA_CMD_ER) && nvm_command(NVMCTRL_CTRLA_CMD_PBC);
+    if (ok)
+    {
+        for (unsigned int i = 0; i < sizeof(rec) / 4; i++)
+            dst[i] = src[i];
+        ok = nvm_command(NVMCTRL_CTRLA_CMD_WP) && nvm_command(NVMCTRL_CTRLA_CMD_INVALL);
+    }
+    __set_PRIMASK(primask);
+
+    return ok && memcmp((const void*)ADC_CALIBRATION_ADDR, &rec, sizeof(rec)) == 0;
+}
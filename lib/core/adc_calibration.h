@@ -0,0 +1,74 @@
+/*******************************************************************************
+ * ADC offset and gain calibration, stored in the last row of flash
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+/*
+ * adc_calibrate() measures a pin tied to GND and a pin tied to the top of the
+ * input range (3.3V with the default reference) and binary searches OFFSETCORR
+ * for the smallest offset that reads 0, then GAINCORR for the smallest gain
+ * that reads full scale. Every reading is 16 conversions averaged in hardware,
+ * so the whole search takes about 10ms.
+ *
+ * adc_calibration_store() saves the result in the last flash row, which the
+ * linker scripts leave out of FLASH, and init() calls adc_calibration_load()
+ * so every sketch gets the correction with no code. The adc-correction sketch
+ * does the calibrate and store steps.
+ */
+
+#ifndef ADC_CALIBRATION_H
+#define ADC_CALIBRATION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sam.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// reserved by the linker scripts and skipped by the bootloader's erase
+#define ADC_CALIBRATION_ADDR (FLASH_SIZE - NVMCTRL_ROW_SIZE)
+
+#define ADC_GAINCORR_UNITY 0x800
+
+typedef struct {
+    int16_t offset;     // OFFSETCORR, subtracted from the result
+    uint16_t gain;      // GAINCORR, ADC_GAINCORR_UNITY is 1.0
+} AdcCalibration;
+
+// Measure the correction. The ADC state and analogRead() settings are kept,
+// and the result is applied. Returns false if either search ran out of range,
+// e.g. the pins aren't connected.
+bool adc_calibrate(uint32_t gnd_pin, uint32_t top_pin, AdcCalibration *cal);
+
+// Write OFFSETCORR and GAINCORR and enable correction
+void adc_calibration_apply(const AdcCalibration *cal);
+
+// Apply the stored calibration. Returns false (and changes nothing) if none
+// has been stored.
+bool adc_calibration_load(void);
+
+// Save to flash, or erase the stored calibration. Return false on an NVM error.
+bool adc_calibration_store(const AdcCalibration *cal);
+bool adc_calibration_erase(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ADC_CALIBRATION_H
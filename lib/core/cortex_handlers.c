@@ -72,6 +72,83 @@ void DAC_Handler      (void) __attribute__ ((weak, alias("Dummy_Handler")));
 void PTC_Handler      (void) __attribute__ ((weak, alias("Dummy_Handler")));
 void I2S_Handler      (void) __attribute__ ((weak, alias("Dummy_Handler")));
 
+#ifdef IRQ_STATS
+#include "IrqStats.h"
+
+static IrqStats irqStats[PERIPH_COUNT_IRQn];
+
+/* SysTick counts down and reloads every ms, handlers shorter than that wrap at most once */
+static inline void irqStatsRecord(IRQn_Type irq, uint32_t start)
+{
+  const uint32_t end = SysTick->VAL;
+  const uint32_t cycles = (start >= end) ? (start - end) : (start + SysTick->LOAD + 1 - end);
+  IrqStats *s = &irqStats[irq];
+  s->count++;
+  s->totalCycles += cycles;
+  if (cycles > s->maxCycles)
+    s->maxCycles = cycles;
+}
+
+#define IRQ_STATS_WRAPPER(name) \
+  static void name##_StatsHandler(void) \
+  { \
+    const uint32_t start = SysTick->VAL; \
+    name##_Handler(); \
+    irqStatsRecord(name##_IRQn, start); \
+  }
+#define IRQ_VECTOR(name) name##_StatsHandler
+
+/* TCCx aren't wrapped, the Profiler's TCC2_Handler needs to be entered directly from the vector */
+
+IRQ_STATS_WRAPPER(EIC)
+IRQ_STATS_WRAPPER(DMAC)
+IRQ_STATS_WRAPPER(USB)
+IRQ_STATS_WRAPPER(SERCOM0)
+IRQ_STATS_WRAPPER(SERCOM1)
+IRQ_STATS_WRAPPER(SERCOM2)
+IRQ_STATS_WRAPPER(SERCOM3)
+IRQ_STATS_WRAPPER(SERCOM4)
+IRQ_STATS_WRAPPER(SERCOM5)
+IRQ_STATS_WRAPPER(TC3)
+IRQ_STATS_WRAPPER(TC4)
+IRQ_STATS_WRAPPER(TC5)
+
+static const IRQn_Type irqStatsList[] = {
+  EIC_IRQn, DMAC_IRQn, USB_IRQn,
+  SERCOM0_IRQn, SERCOM1_IRQn, SERCOM2_IRQn, SERCOM3_IRQn, SERCOM4_IRQn, SERCOM5_IRQn,
+  TC3_IRQn, TC4_IRQn, TC5_IRQn,
+};
+
+int irqStatsGet(IRQn_Type irq, IrqStats *stats)
+{
+  unsigned int i;
+  for (i = 0; i < sizeof(irqStatsList) / sizeof(irqStatsList[0]); i++)
+  {
+    if (irqStatsList[i] == irq)
+    {
+      const uint32_t primask = __get_PRIMASK();
+      __disable_irq();
+      *stats = irqStats[irq];
+      __set_PRIMASK(primask);
+      return 0;
+    }
+  }
+  return -1;
+}
+
+void irqStatsReset(void)
+{
+  unsigned int i;
+  const uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  for (i = 0; i < PERIPH_COUNT_IRQn; i++)
+    irqStats[i].count = irqStats[i].maxCycles = irqStats[i].totalCycles = 0;
+  __set_PRIMASK(primask);
+}
+#else
+#define IRQ_VECTOR(name) name##_Handler
+#endif
+
 /* Initialize segments */
 extern uint32_t __etext;
 extern uint32_t __data_start__;
@@ -107,23 +184,23 @@ __attribute__ ((used, section(".isr_vector"))) const DeviceVectors exception_tab
   (void*) SYSCTRL_Handler,        /*  1 System Control */
   (void*) WDT_Handler,            /*  2 Watchdog Timer */
   (void*) RTC_Handler,            /*  3 Real-Time Counter */
-  (void*) EIC_Handler,            /*  4 External Interrupt Controller */
+  (void*) IRQ_VECTOR(EIC),        /*  4 External Interrupt Controller */
   (void*) NVMCTRL_Handler,        /*  5 Non-Volatile Memory Controller */
-  (void*) DMAC_Handler,           /*  6 Direct Memory Access Controller */
-  (void*) USB_Handler,            /*  7 Universal Serial Bus */
+  (void*) IRQ_VECTOR(DMAC),       /*  6 Direct Memory Access Controller */
+  (void*) IRQ_VECTOR(USB),        /*  7 Universal Serial Bus */
   (void*) EVSYS_Handler,          /*  8 Event System Interface */
-  (void*) SERCOM0_Handler,        /*  9 Serial Communication Interface 0 */
-  (void*) SERCOM1_Handler,        /* 10 Serial Communication Interface 1 */
-  (void*) SERCOM2_Handler,        /* 11 Serial Communication Interface 2 */
-  (void*) SERCOM3_Handler,        /* 12 Serial Communication Interface 3 */
-  (void*) SERCOM4_Handler,        /* 13 Serial Communication Interface 4 */
-  (void*) SERCOM5_Handler,        /* 14 Serial Communication Interface 5 */
+  (void*) IRQ_VECTOR(SERCOM0),    /*  9 Serial Communication Interface 0 */
+  (void*) IRQ_VECTOR(SERCOM1),    /* 10 Serial Communication Interface 1 */
+  (void*) IRQ_VECTOR(SERCOM2),    /* 11 Serial Communication Interface 2 */
+  (void*) IRQ_VECTOR(SERCOM3),    /* 12 Serial Communication Interface 3 */
+  (void*) IRQ_VECTOR(SERCOM4),    /* 13 Serial Communication Interface 4 */
+  (void*) IRQ_VECTOR(SERCOM5),    /* 14 Serial Communication Interface 5 */
   (void*) TCC0_Handler,           /* 15 Timer Counter Control 0 */
   (void*) TCC1_Handler,           /* 16 Timer Counter Control 1 */
   (void*) TCC2_Handler,           /* 17 Timer Counter Control 2 */
-  (void*) TC3_Handler,            /* 18 Basic Timer Counter 0 */
-  (void*) TC4_Handler,            /* 19 Basic Timer Counter 1 */
-  (void*) TC5_Handler,            /* 20 Basic Timer Counter 2 */
+  (void*) IRQ_VECTOR(TC3),        /* 18 Basic Timer Counter 0 */
+  (void*) IRQ_VECTOR(TC4),        /* 19 Basic Timer Counter 1 */
+  (void*) IRQ_VECTOR(TC5),        /* 20 Basic Timer Counter 2 */
   (void*) TC6_Handler,            /* 21 Basic Timer Counter 3 */
   (void*) TC7_Handler,            /* 22 Basic Timer Counter 4 */
   (void*) ADC_Handler,            /* 23 Analog Digital Converter */
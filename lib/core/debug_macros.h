@@ -20,14 +20,28 @@
 #ifndef DEBUG_MACROS_H
 #define DEBUG_MACROS_H
 
+/*
+ * Define DEBUG_PORT and DEBUG_PIN to toggle a pin for a logic analyzer, and/or
+ * DEBUG_TRACE_ID to record DBGHIGH()/DBGLOW() as begin/end events with that ID
+ * in the trace buffer (see Trace.h, also needs TRACE_ENABLE).
+ */
+#ifdef DEBUG_TRACE_ID
+#include "Trace.h"
+#define DBG_TRACE_HIGH() TRACE_BEGIN(DEBUG_TRACE_ID)
+#define DBG_TRACE_LOW()  TRACE_END(DEBUG_TRACE_ID)
+#else
+#define DBG_TRACE_HIGH() do { } while(0)
+#define DBG_TRACE_LOW()  do { } while(0)
+#endif
+
 #if defined(DEBUG_PORT) && defined(DEBUG_PIN)
 #define DBGINIT() do { PORT->Group[DEBUG_PORT].DIRSET.reg = 1UL << (DEBUG_PIN); } while (0)
-#define DBGHIGH() do { PORT->Group[DEBUG_PORT].OUTSET.reg = 1UL << (DEBUG_PIN); } while (0)
-#define DBGLOW()  do { PORT->Group[DEBUG_PORT].OUTCLR.reg = 1UL << (DEBUG_PIN); } while (0)
+#define DBGHIGH() do { PORT->Group[DEBUG_PORT].OUTSET.reg = 1UL << (DEBUG_PIN); DBG_TRACE_HIGH(); } while (0)
+#define DBGLOW()  do { DBG_TRACE_LOW(); PORT->Group[DEBUG_PORT].OUTCLR.reg = 1UL << (DEBUG_PIN); } while (0)
 #else
 #define DBGINIT() do { } while(0)
-#define DBGHIGH() do { } while(0)
-#define DBGLOW()  do { } while(0)
+#define DBGHIGH() DBG_TRACE_HIGH()
+#define DBGLOW()  DBG_TRACE_LOW()
 #endif
 
 #endif
@@ -19,6 +19,31 @@
 #include "delay.h"
 #include "Arduino.h"
 
+#ifdef MICROS_USE_HWCLOCK
+#include "HwClock.h"
+#if HWCLOCK_FREQ_HZ != 1000000ul
+#error MICROS_USE_HWCLOCK requires HWCLOCK_FREQ_HZ to be 1MHz
+#endif
+#endif
+
+#ifdef DELAY_SLEEP
+#ifndef MICROS_USE_HWCLOCK
+#error DELAY_SLEEP requires MICROS_USE_HWCLOCK
+#endif
+
+// Don't sleep for less than this, the alarm might be missed while CC0 syncs
+// and the busy loop is more accurate for the last few microseconds anyway.
+#ifndef DELAY_SLEEP_MIN_US
+#define DELAY_SLEEP_MIN_US 20
+#endif
+
+// With DELAY_SLEEP_SUPPRESS_SYSTICK, sleeps at least this long stop SysTick
+// and correct the millisecond count afterwards
+#ifndef DELAY_SLEEP_SYSTICK_MIN_US
+#define DELAY_SLEEP_SYSTICK_MIN_US 2000
+#endif
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -26,6 +51,11 @@ extern "C" {
 /** Tick Counter united by ms */
 static volatile uint32_t _ulTickCount=0 ;
 
+#ifdef DELAY_SLEEP
+/** Total time spent sleeping in delay(), in microseconds */
+static volatile uint32_t _ulIdleMicros=0 ;
+#endif
+
 unsigned long millis( void )
 {
 // todo: ensure no interrupts
@@ -36,6 +66,13 @@ unsigned long millis( void )
 // Theory: repeatedly take readings of SysTick counter, millis counter and SysTick interrupt pending flag.
 // When it appears that millis counter and pending is stable and SysTick hasn't rolled over, use these
 // values to calculate micros. If there is a pending SysTick, add one to the millis counter in the calculation.
+#ifdef MICROS_USE_HWCLOCK
+// TC4/TC5 count microseconds directly, no need to reconcile SysTick and the tick count
+unsigned long micros( void )
+{
+  return hwclock_read();
+}
+#else
 unsigned long micros( void )
 {
   uint32_t ticks, ticks2;
@@ -60,6 +97,97 @@ unsigned long micros( void )
   // this is an optimization to turn a runtime division into two compile-time divisions and
   // a runtime multiplication and shift, saving a few cycles
 }
+#endif
+
+#ifdef DELAY_SLEEP
+#ifdef DELAY_SLEEP_SUPPRESS_SYSTICK
+// microseconds of suppressed SysTick time not yet added to _ulTickCount
+static uint32_t _ulTickCarry = 0 ;
+
+// Stop SysTick, returning the microseconds already elapsed in the current tick
+static uint32_t systickSuspend( void )
+{
+  SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk ;
+  return ((SysTick->LOAD - SysTick->VAL) * (1048576/(VARIANT_MCK/1000000))) >> 20 ;
+}
+
+// Add the ticks missed while SysTick was stopped and restart it. Writing VAL
+// always clears it, so the next tick is a full period away and the leftover
+// fraction of a tick is carried to the next correction.
+static void systickResume( uint32_t elapsed )
+{
+  // a tick may have come due just before the counter stopped
+  if ( SCB->ICSR & SCB_ICSR_PENDSTSET_Msk )
+  {
+    SCB->ICSR = SCB_ICSR_PENDSTCLR_Msk ;
+    elapsed += 1000 ;
+  }
+
+  elapsed += _ulTickCarry ;
+  _ulTickCount += elapsed / 1000 ;
+  _ulTickCarry = elapsed % 1000 ;
+
+  SysTick->VAL = 0 ;
+  SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk ;
+}
+#endif
+
+// Sleep until the hwclock reaches wake, yield()'s next deadline, or any
+// interrupt fires. Interrupts are masked so there's no race between arming the
+// alarm and __WFI, a pending interrupt still ends the sleep and its handler runs
+// as soon as they're unmasked. The deadline is checked under the same mask, so
+// an interrupt that gives yield() work (e.g. Task::signal()) either shows up in
+// it or is pending and ends the sleep.
+static void delaySleepUntil( uint32_t wake )
+{
+  const uint32_t primask = __get_PRIMASK() ;
+  __disable_irq() ;
+
+  uint32_t hint ;
+  if ( yieldNextWake( &hint ) && (int32_t)(hint - wake) < 0 )
+    wake = hint ;
+
+  if ( (int32_t)(wake - hwclock_read()) > DELAY_SLEEP_MIN_US )
+  {
+    hwclock_set_alarm( wake ) ;
+
+    const uint32_t t0 = hwclock_read() ;
+    const int32_t remaining = (int32_t)(wake - t0) ;
+    if ( remaining > 0 )
+    {
+#ifdef DELAY_SLEEP_SUPPRESS_SYSTICK
+      const bool suspend = remaining >= DELAY_SLEEP_SYSTICK_MIN_US ;
+      const uint32_t phase = suspend ? systickSuspend() : 0 ;
+#endif
+
+      __DSB() ;
+      __WFI() ;
+
+      const uint32_t slept = hwclock_read() - t0 ;
+      _ulIdleMicros += slept ;
+
+#ifdef DELAY_SLEEP_SUPPRESS_SYSTICK
+      if ( suspend )
+        systickResume( phase + slept ) ;
+#endif
+    }
+
+    hwclock_clear_alarm() ;
+  }
+
+  __set_PRIMASK( primask ) ;
+}
+
+unsigned long idleMicros( void )
+{
+  return _ulIdleMicros ;
+}
+#else
+unsigned long idleMicros( void )
+{
+  return 0 ;
+}
+#endif
 
 void delay( unsigned long ms )
 {
@@ -78,6 +206,13 @@ void delay( unsigned long ms )
       ms--;
       start += 1000;
     }
+#ifdef DELAY_SLEEP
+    // Sleep until the end of the delay (capped so the wraparound comparison
+    // works). Other interrupts wake up early, and they and yield() run as usual.
+    // yield() may need to run sooner, e.g. for a Scheduler task's wake time.
+    if (ms > 0)
+      delaySleepUntil( start + 1000 * (ms < 1000000 ? ms : 1000000) ) ;
+#endif
   }
 }
 
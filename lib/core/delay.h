@@ -35,6 +35,14 @@ extern "C" {
  */
 extern unsigned long millis( void ) ;
 
+/**
+ * \brief Returns the total time spent asleep in delay(), in microseconds.
+ *
+ * Only counts when built with -DDELAY_SLEEP, otherwise always 0. Sampling this
+ * and micros() twice gives the idle fraction over the interval.
+ */
+extern unsigned long idleMicros( void ) ;
+
 /**
  * \brief Returns the number of microseconds since the Arduino board began running the current program.
  *
@@ -0,0 +1,164 @@
+/*******************************************************************************
+ * Division-free number formatting helpers for Print
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#include <math.h>
+#include <string.h>
+
+#include "fmtnum.h"
+
+static const char hex_upper[16] = "0123456789ABCDEF";
+static const char hex_lower[16] = "0123456789abcdef";
+
+// 10^n for each supported number of fractional digits
+static const uint32_t pow10_table[FMT_DOUBLE_MAX_DIGITS + 1] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000,
+};
+
+// Print::printFloat rounds by repeatedly dividing 0.5 by 10. Spell the same
+// divisions out here so the compiler folds them to identical constants.
+static const double rounding_table[FMT_DOUBLE_MAX_DIGITS + 1] = {
+    0.5,
+    0.5 / 10.0,
+    0.5 / 10.0 / 10.0,
+    0.5 / 10.0 / 10.0 / 10.0,
+    0.5 / 10.0 / 10.0 / 10.0 / 10.0,
+    0.5 / 10.0 / 10.0 / 10.0 / 10.0 / 10.0,
+    0.5 / 10.0 / 10.0 / 10.0 / 10.0 / 10.0 / 10.0,
+    0.5 / 10.0 / 10.0 / 10.0 / 10.0 / 10.0 / 10.0 / 10.0,
+    0.5 / 10.0 / 10.0 / 10.0 / 10.0 / 10.0 / 10.0 / 10.0 / 10.0,
+    0.5 / 10.0 / 10.0 / 10.0 / 10.0 / 10.0 / 10.0 / 10.0 / 10.0 / 10.0,
+};
+
+char *fmt_u32_dec(char *end, uint32_t n)
+{
+    char *p = end;
+    do {
+        uint32_t q = fmt_divu10(n);
+        *--p = (char)('0' + (n - q * 10));
+        n = q;
+    } while (n);
+    return p;
+}
+
+char *fmt_u32_hex(char *end, uint32_t n, bool upper)
+{
+    const char *digits = upper ? hex_upper : hex_lower;
+    char *p = end;
+    do {
+        *--p = digits[n & 0xf];
+        n >>= 4;
+    } while (n);
+    return p;
+}
+
+char *fmt_u32(char *end, uint32_t n, uint8_t base)
+{
+    // prevent crash if called with base == 1
+    if (base < 2)
+        base = 10;
+
+    if (base == 10)
+        return fmt_u32_dec(end, n);
+    if (base == 16)
+        return fmt_u32_hex(end, n, true);
+
+    char *p = end;
+    if ((base & (base - 1)) == 0)
+    {
+        // other powers of 2 (binary, octal) are also just shifts
+        unsigned shift = 0;
+        while ((1u << shift) != base)
+            shift++;
+        const uint32_t mask = base - 1;
+        do {
+            *--p = hex_upper[n & mask];
+            n >>= shift;
+        } while (n);
+        return p;
+    }
+
+    // arbitrary bases still need the slow division
+    do {
+        char c = (char)(n % base);
+        n /= base;
+        *--p = c < 10 ? c + '0' : c + 'A' - 10;
+    } while (n);
+    return p;
+}
+
+static size_t copy_str(char *buf, const char *s)
+{
+    size_t len = strlen(s);
+    memcpy(buf, s, len);
+    return len;
+}
+
+size_t fmt_double(char *buf, double number, uint8_t digits)
+{
+    char *p = buf;
+
+    if (isnan(number)) return copy_str(buf, "nan");
+    if (isinf(number)) return copy_str(buf, "inf");
+    if (number > 4294967040.0) return copy_str(buf, "ovf");  // constant determined empirically
+    if (number <-4294967040.0) return copy_str(buf, "ovf");  // constant determined empirically
+
+    if (digits > FMT_DOUBLE_MAX_DIGITS)
+        digits = FMT_DOUBLE_MAX_DIGITS;
+
+    if (number < 0.0)
+    {
+        *p++ = '-';
+        number = -number;
+    }
+
+    // Round correctly so that print(1.999, 2) prints as "2.00"
+    number += rounding_table[digits];
+
+    uint32_t int_part = (uint32_t)number;
+    double remainder = number - (double)int_part;
+
+    char tmp[10];
+    char *s = fmt_u32_dec(tmp + sizeof(tmp), int_part);
+    size_t len = (size_t)(tmp + sizeof(tmp) - s);
+    memcpy(p, s, len);
+    p += len;
+
+    if (digits > 0)
+    {
+        *p++ = '.';
+
+        // Scale the whole fraction at once rather than one software-float
+        // multiply and subtract per digit, then zero-pad on the left. The
+        // product is rounded once instead of per digit, so a fraction within
+        // double rounding of the next digit can print one higher in the last
+        // place than the old loop did, e.g. 20.499858385 with 8 digits is now
+        // 20.49985839 rather than 20.49985838.
+        uint32_t frac = (uint32_t)(remainder * pow10_table[digits]);
+        if (frac >= pow10_table[digits])
+            frac = pow10_table[digits] - 1;
+
+        char *end = p + digits;
+        s = fmt_u32_dec(end, frac);
+        while (s > p)
+            *--s = '0';
+        p = end;
+    }
+
+    return (size_t)(p - buf);
+}
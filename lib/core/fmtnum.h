@@ -0,0 +1,77 @@
+/*******************************************************************************
+ * Division-free number formatting helpers for Print
+ *
+ * Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <https://www.gnu.org/licenses/>.
+ ******************************************************************************/
+
+#ifndef FMTNUM_H
+#define FMTNUM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Largest number of characters fmt_u32 can produce (base 2)
+#define FMT_U32_MAX_LEN 32
+
+// printFloat-style formatting is only done in fixed point up to this many
+// digits after the decimal point, because 10^9 is the largest power of 10
+// that fits in a uint32_t.
+#define FMT_DOUBLE_MAX_DIGITS 9
+
+// Enough for "-4294967295.123456789"
+#define FMT_DOUBLE_MAX_LEN (1 + 10 + 1 + FMT_DOUBLE_MAX_DIGITS)
+
+// The Cortex-M0+ has no hardware divider, so n/10 would be a libgcc call.
+// This is the shift-and-add reciprocal from Hacker's Delight (fig 10-12),
+// which is exact for all 32-bit inputs.
+static inline uint32_t fmt_divu10(uint32_t n)
+{
+    uint32_t q = (n >> 1) + (n >> 2);
+    q += q >> 4;
+    q += q >> 8;
+    q += q >> 16;
+    q >>= 3;
+    uint32_t r = n - (((q << 2) + q) << 1);
+    return q + (r > 9);
+}
+
+/*
+ * The fmt_u32 functions write digits backwards ending just before end, and return
+ * a pointer to the most significant digit. At least one digit is always written.
+ * No null terminator is added.
+ */
+char *fmt_u32_dec(char *end, uint32_t n);
+char *fmt_u32_hex(char *end, uint32_t n, bool upper);
+char *fmt_u32(char *end, uint32_t n, uint8_t base);
+
+/*
+ * Format number in the same way as Print::printFloat, except that the last
+ * digit can be one higher where the old per-digit loop lost precision. buf
+ * must have room for FMT_DOUBLE_MAX_LEN characters, and digits must be
+ * <= FMT_DOUBLE_MAX_DIGITS.
+ * Returns the number of characters written, without a null terminator.
+ */
+size_t fmt_double(char *buf, double number, uint8_t digits);
+
+#ifdef __cplusplus
+}
+#endif
+#endif // FMTNUM_H
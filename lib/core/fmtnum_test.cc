@@ -0,0 +1,226 @@
+/*
+ * fmtnum_test.cc: console application to check the fmtnum.c formatting against
+ * the original Print::printNumber and Print::printFloat algorithms, and to
+ * benchmark them against each other. Floats may differ by one in the last
+ * digit, which is counted but not a failure.
+ * Extension is .cc instead of .cpp so that the samd21 Makefile ignores it.
+ *
+ * Build and run:
+ *   g++ -O2 -Wall -o fmtnum_test fmtnum_test.cc -x c fmtnum.c
+ *   ./fmtnum_test        # quick check and benchmark
+ *   ./fmtnum_test -x     # exhaustive check of all 2^32 integers (takes minutes)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <string>
+
+#include "fmtnum.h"
+
+// The original Print::printNumber, returning a string rather than calling write()
+static std::string ref_number(uint32_t n, uint8_t base)
+{
+    char buf[8 * sizeof(long) + 1];
+    char *str = &buf[sizeof(buf) - 1];
+
+    *str = '\0';
+
+    if (base < 2) base = 10;
+
+    do {
+        char c = n % base;
+        n /= base;
+
+        *--str = c < 10 ? c + '0' : c + 'A' - 10;
+    } while(n);
+
+    return str;
+}
+
+// The original Print::printFloat
+static std::string ref_float(double number, uint8_t digits)
+{
+    std::string s;
+
+    if (isnan(number)) return "nan";
+    if (isinf(number)) return "inf";
+    if (number > 4294967040.0) return "ovf";
+    if (number <-4294967040.0) return "ovf";
+
+    if (number < 0.0)
+    {
+        s += '-';
+        number = -number;
+    }
+
+    double rounding = 0.5;
+    for (uint8_t i=0; i<digits; ++i)
+        rounding /= 10.0;
+
+    number += rounding;
+
+    uint32_t int_part = (uint32_t)number;
+    double remainder = number - (double)int_part;
+    s += ref_number(int_part, 10);
+
+    if (digits > 0)
+        s += '.';
+
+    while (digits-- > 0)
+    {
+        remainder *= 10.0;
+        unsigned int toPrint = (unsigned int)(remainder);
+        s += ref_number(toPrint, 10);
+        remainder -= toPrint;
+    }
+
+    return s;
+}
+
+static std::string new_number(uint32_t n, uint8_t base)
+{
+    char buf[FMT_U32_MAX_LEN];
+    char *end = buf + sizeof(buf);
+    char *s = fmt_u32(end, n, base);
+    return std::string(s, end - s);
+}
+
+static std::string new_float(double number, uint8_t digits)
+{
+    char buf[FMT_DOUBLE_MAX_LEN];
+    return std::string(buf, fmt_double(buf, number, digits));
+}
+
+static unsigned long failures = 0;
+
+static void check_number(uint32_t n, uint8_t base)
+{
+    std::string a = ref_number(n, base), b = new_number(n, base);
+    if (a != b && failures++ < 20)
+        printf("FAIL number %u base %u: '%s' != '%s'\n", n, base, a.c_str(), b.c_str());
+}
+
+// fmt_double rounds the scaled fraction once rather than once per digit, so
+// it may print one more in the last place than the old loop. Anything else is
+// a failure.
+static unsigned long last_digit_diffs = 0;
+
+static bool last_digit_higher(const std::string &ref, const std::string &s, uint8_t digits)
+{
+    if (digits == 0)
+        return false;
+    const double step = pow(10.0, -digits);
+    const double diff = fabs(strtod(s.c_str(), NULL)) - fabs(strtod(ref.c_str(), NULL));
+    return diff > step * 0.5 && diff < step * 1.5;
+}
+
+static void check_float(double d, uint8_t digits)
+{
+    std::string a = ref_float(d, digits), b = new_float(d, digits);
+    if (a == b)
+        return;
+    if (last_digit_higher(a, b, digits))
+        last_digit_diffs++;
+    else if (failures++ < 20)
+        printf("FAIL float %.17g digits %u: '%s' != '%s'\n", d, digits, a.c_str(), b.c_str());
+}
+
+// exact output expected, where it differs from the old loop
+static void check_float_exact(double d, uint8_t digits, const char *expected)
+{
+    std::string b = new_float(d, digits);
+    if (b != expected && failures++ < 20)
+        printf("FAIL float %.17g digits %u: '%s' != '%s'\n", d, digits, expected, b.c_str());
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+template<typename F>
+static void bench(const char *name, F fn, unsigned iters)
+{
+    volatile size_t sink = 0;
+    double start = now();
+    for (unsigned i = 0; i < iters; i++)
+        sink = sink + fn(i);
+    double elapsed = now() - start;
+    printf("%-24s %8.1f ns/call\n", name, elapsed * 1e9 / iters);
+}
+
+int main(int argc, char **argv)
+{
+    const bool exhaustive = (argc > 1 && !strcmp(argv[1], "-x"));
+    static const uint8_t bases[] = { 2, 8, 10, 16, 3, 36 };
+
+    srand48(0xC0FFEE);
+
+    if (exhaustive)
+    {
+        for (uint8_t base : { 10, 16, 8, 2 })
+        {
+            printf("checking all 32-bit integers in base %u\n", base);
+            uint32_t n = 0;
+            do {
+                check_number(n, base);
+            } while (++n != 0);
+        }
+    }
+    else
+    {
+        for (uint8_t base : bases)
+        {
+            for (uint32_t n = 0; n < 1000000; n++)
+                check_number(n, base);
+            for (uint32_t n = 0xffffffffu; n > 0xffffffffu - 1000000; n--)
+                check_number(n, base);
+            for (int i = 0; i < 1000000; i++)
+                check_number((uint32_t)mrand48(), base);
+        }
+    }
+
+    static const double specials[] = {
+        0.0, -0.0, 0.5, 1.999, -1.999, 0.1, 0.3, 123.456, 4294967040.0, 4294967041.0,
+        -4294967041.0, NAN, INFINITY, -INFINITY, 1e-12, 9.9999999999, 0.00049999,
+        20.499858385, 125.696979695,
+    };
+    for (double d : specials)
+        for (uint8_t digits = 0; digits <= FMT_DOUBLE_MAX_DIGITS; digits++)
+            check_float(d, digits);
+
+    const int nfloat = exhaustive ? 100000000 : 2000000;
+    for (int i = 0; i < nfloat; i++)
+    {
+        // mix of magnitudes, from small fractions up to the ovf limit
+        double d = (drand48() - 0.5) * pow(10.0, (int)(drand48() * 11) - 1);
+        check_float(d, (uint8_t)(i % (FMT_DOUBLE_MAX_DIGITS + 1)));
+    }
+
+    // the fraction is just under the next digit, the old loop printed ...838
+    // and ...969
+    check_float_exact(20.499858385, 8, "20.49985839");
+    check_float_exact(125.696979695, 8, "125.69697970");
+    check_float_exact(-20.499858385, 8, "-20.49985839");
+    check_float_exact(1.999, 2, "2.00");
+    check_float_exact(0.0, 0, "0");
+
+    printf("%lu last digit differences from the old loop\n", last_digit_diffs);
+    printf("%lu failures\n", failures);
+
+    bench("ref_number base 10", [](unsigned i) { return ref_number(i * 2654435761u, 10).size(); }, 5000000);
+    bench("new_number base 10", [](unsigned i) { return new_number(i * 2654435761u, 10).size(); }, 5000000);
+    bench("ref_number base 16", [](unsigned i) { return ref_number(i * 2654435761u, 16).size(); }, 5000000);
+    bench("new_number base 16", [](unsigned i) { return new_number(i * 2654435761u, 16).size(); }, 5000000);
+    bench("ref_float 2 digits", [](unsigned i) { return ref_float(i * 0.37, 2).size(); }, 2000000);
+    bench("new_float 2 digits", [](unsigned i) { return new_float(i * 0.37, 2).size(); }, 2000000);
+    bench("ref_float 6 digits", [](unsigned i) { return ref_float(i * 0.37, 6).size(); }, 2000000);
+    bench("new_float 6 digits", [](unsigned i) { return new_float(i * 0.37, 6).size(); }, 2000000);
+
+    return failures ? 1 : 0;
+}
@@ -16,6 +16,8 @@
   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 */
 
+#include <stdint.h>
+
 /**
  * Empty yield() hook.
  *
@@ -30,6 +32,21 @@ static void __empty() {
 }
 void yield(void) __attribute__ ((weak, alias("__empty")));
 
+/**
+ * yield() wake hint.
+ *
+ * A sleeping delay() calls this to find out when yield() next has work to do,
+ * so it can wake up in time. Returns non-zero and sets *us to a micros() value
+ * if there's a deadline. The default has none.
+ * It's called with interrupts masked, right before sleeping, and must not
+ * unmask them or wait on an interrupt.
+ */
+static int __noWake(uint32_t *us) {
+	(void)us;
+	return 0;
+}
+int yieldNextWake(uint32_t *us) __attribute__ ((weak, alias("__noWake")));
+
 /**
  * SysTick hook
  *
@@ -0,0 +1,225 @@
+/*
+ * linereader_test.cc: console application to check LineReader against the
+ * blocking Stream::readLine it replaces. Random typing (letters, spaces,
+ * backspaces and CRs) goes through both, and the lines and echo output must
+ * match byte for byte, for a range of buffer sizes, with and without echo.
+ * Extension is .cc instead of .cpp so that the samd21 Makefile ignores it.
+ *
+ * Input arrives a few bytes at a time between polls, and the stream hands out
+ * at most a random chunk size per readAvailable() call, so lines and
+ * backspaces are split across polls and chunks at every offset. Half the runs
+ * use the default readAvailable() built on available() and read().
+ *
+ * Build and run:
+ *   gcc -O2 -c fmtnum.c
+ *   g++ -O2 -Wall -Wextra -o linereader_test linereader_test.cc LineReader.cpp Print.cpp PrintFormat.cpp fmtnum.o
+ *   ./linereader_test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "LineReader.h"
+#include "../host_test.h"
+
+#define NUM_RUNS 200000
+
+// Stream.cpp needs Arduino.h, so define the default readAvailable here, as
+// it is there
+size_t Stream::readAvailable(uint8_t *buffer, size_t length)
+{
+    size_t count = 0;
+    while (count < length && available() > 0) {
+        int c = read();
+        if (c < 0)
+            break;
+        buffer[count++] = (uint8_t)c;
+    }
+    return count;
+}
+
+// Input in a string, of which only the first 'arrived' bytes can be read yet
+class TestStream : public Stream
+{
+    public:
+        std::string in;
+        std::string out;
+        size_t pos = 0;
+        size_t arrived = 0;
+        size_t max_chunk = 0;   // 0 to use the default readAvailable()
+
+        int available() override { return (int)(arrived - pos); }
+        int read() override { return pos < arrived ? (uint8_t)in[pos++] : -1; }
+        int peek() override { return pos < arrived ? (uint8_t)in[pos] : -1; }
+        size_t write(uint8_t c) override { out += (char)c; return 1; }
+        size_t write(const uint8_t *buf, size_t n) override { out.append((const char*)buf, n); return n; }
+        using Print::write;
+
+        size_t readAvailable(uint8_t *buffer, size_t length) override
+        {
+            if (max_chunk == 0)
+                return Stream::readAvailable(buffer, length);
+            size_t n = arrived - pos;
+            if (n > length) n = length;
+            if (n > max_chunk) n = max_chunk;
+            memcpy(buffer, in.data() + pos, n);
+            pos += n;
+            return n;
+        }
+};
+
+struct Result
+{
+    std::vector<std::string> lines;
+    std::string echo;
+    uint32_t overflows = 0;
+    uint32_t dropped = 0;
+};
+
+// The original Stream::readLine, reading from a string that ends with a CR,
+// plus counts of the lines it truncated and the characters it threw away
+static size_t ref_readLine(TestStream &s, char *buf, size_t bufsize, bool echo, Result &r)
+{
+    static const char CRLF[] = "\r\n";
+    size_t count = 0;
+    char c = 0;
+
+    while (count < bufsize-1) {
+        c = s.read();
+        if (c == '\r') {
+            if (echo) s.print(CRLF);
+            break;
+        } else if (count && (c == '\b')) {
+            buf[--count] = '\0';
+            if (echo) s.print("\b \b");
+        } else {
+            buf[count++] = c;
+            if (echo) s.print(c);
+        }
+    }
+    buf[count] = '\0';
+    if (count == (bufsize-1) && c != '\r') {
+        bool truncated = false;
+        while (true) {
+            c = s.read();
+            if (c == '\r') {
+                if (echo) s.print(CRLF);
+                break;
+            }
+            if (echo) s.print(c);
+            truncated = true;
+            r.dropped++;
+        }
+        r.overflows += truncated;
+    }
+    return count;
+}
+
+static std::string random_input(void)
+{
+    static const char chars[] = "abcdefghijklmnopqrstuvwxyz0123456789    \b\b\b\r";
+    std::string in;
+    const int len = rand() % 60;
+    for (int i = 0; i < len; i++)
+        in += chars[rand() % (sizeof(chars) - 1)];
+    // readLine would wait forever for the last CR
+    in += '\r';
+    return in;
+}
+
+static Result run_ref(const std::string &in, size_t bufsize, bool echo)
+{
+    Result r;
+    TestStream s;
+    s.in = in;
+    s.arrived = in.size();
+    std::vector<char> buf(bufsize);
+    while (s.pos < s.in.size())
+    {
+        const size_t n = ref_readLine(s, buf.data(), bufsize, echo, r);
+        CHECK(n == strlen(buf.data()), "readLine returned %zu for a %zu character line", n, strlen(buf.data()));
+        r.lines.push_back(buf.data());
+    }
+    r.echo = s.out;
+    return r;
+}
+
+static Result run_reader(const std::string &in, size_t bufsize, bool echo, size_t max_chunk)
+{
+    Result r;
+    TestStream s;
+    s.in = in;
+    s.max_chunk = max_chunk;
+    std::vector<char> buf(bufsize);
+    LineReader reader(buf.data(), bufsize, echo);
+
+    while (true)
+    {
+        while (reader.poll(s))
+            r.lines.push_back(std::string(reader.line(), reader.length()));
+        CHECK(reader.length() == strlen(reader.line()), "length %zu for a %zu character line",
+              reader.length(), strlen(reader.line()));
+        if (s.arrived == s.in.size())
+            break;
+
+        // more input arrives, or none and poll() runs with nothing new
+        if (rand() % 4 == 0)
+        {
+            s.arrived += 1 + rand() % 8;
+            if (s.arrived > s.in.size())
+                s.arrived = s.in.size();
+        }
+    }
+    CHECK(s.pos == s.in.size(), "%zu of %zu bytes read", s.pos, s.in.size());
+    r.echo = s.out;
+    r.overflows = reader.overflows();
+    r.dropped = reader.dropped();
+    return r;
+}
+
+int main(void)
+{
+    unsigned long lines = 0;
+    srand(1);
+
+    for (unsigned long i = 0; i < NUM_RUNS; i++)
+    {
+        const std::string in = random_input();
+        const size_t bufsize = 2 + rand() % 16;
+        const bool echo = rand() % 2;
+        const size_t max_chunk = (rand() % 2) ? 1 + rand() % LINE_READER_CHUNK_SIZE : 0;
+
+        const Result ref = run_ref(in, bufsize, echo);
+        const Result got = run_reader(in, bufsize, echo, max_chunk);
+        lines += ref.lines.size();
+
+        CHECK(got.lines == ref.lines, "run %lu: %zu lines, readLine gave %zu (bufsize %zu)",
+              i, got.lines.size(), ref.lines.size(), bufsize);
+        CHECK(got.echo == ref.echo, "run %lu: echo differs (bufsize %zu, chunk %zu)", i, bufsize, max_chunk);
+        CHECK(got.overflows == ref.overflows && got.dropped == ref.dropped,
+              "run %lu: %u overflows %u dropped, expected %u and %u",
+              i, got.overflows, got.dropped, ref.overflows, ref.dropped);
+    }
+
+    // reset() throws away a partial line and anything buffered after it
+    {
+        char buf[8];
+        TestStream s;
+        LineReader reader(buf);
+        s.in = "abc\rdef";
+        s.arrived = 2;
+        s.max_chunk = LINE_READER_CHUNK_SIZE;
+        CHECK(!reader.poll(s) && reader.length() == 2, "partial line length %zu", reader.length());
+        s.arrived = s.in.size();
+        CHECK(reader.poll(s) && strcmp(reader.line(), "abc") == 0, "line '%s'", reader.line());
+        reader.reset();
+        CHECK(reader.length() == 0 && reader.line()[0] == '\0', "reset left '%s'", reader.line());
+        CHECK(!reader.poll(s) && reader.length() == 0, "buffered input survived reset");
+    }
+
+    printf("%lu runs, %lu lines\n", (unsigned long)NUM_RUNS, lines);
+    return check_result();
+}
@@ -0,0 +1,141 @@
+/*
+ * printformat_test.cc: console application to check the compile-time parsed
+ * "..."_fmt printf against snprintf for the integer and string conversions,
+ * with flags, widths and precisions. %f and %p are checked against fixed
+ * strings since they follow Print and newlib rather than glibc.
+ * Extension is .cc instead of .cpp so that the samd21 Makefile ignores it.
+ *
+ * Build and run:
+ *   gcc -O2 -c fmtnum.c
+ *   g++ -O2 -Wall -std=gnu++14 -o printformat_test printformat_test.cc PrintFormat.cpp fmtnum.o
+ *   ./printformat_test
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+#include "Print.h"
+
+// Print.cpp needs Arduino.h, so define the one out-of-line virtual here
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+    size_t n = 0;
+    while (size--)
+    {
+        if (write(*buffer++)) n++;
+        else break;
+    }
+    return n;
+}
+
+class StringPrint : public Print
+{
+    public:
+        std::string s;
+        size_t write(uint8_t c) override { s += (char)c; return 1; }
+        using Print::write;
+};
+
+static unsigned long checks = 0, failures = 0;
+
+static void check(const char *what, const std::string &got, size_t n, const std::string &expected)
+{
+    checks++;
+    if ((got != expected || n != expected.size()) && failures++ < 20)
+        printf("FAIL %s: '%s' (%zu) != '%s'\n", what, got.c_str(), n, expected.c_str());
+}
+
+// compare one format against snprintf for a value
+#define CHECK_SNPRINTF(fmt, value) do { \
+    StringPrint p; \
+    char ref[64]; \
+    snprintf(ref, sizeof(ref), fmt, value); \
+    size_t n = p.printf(fmt ## _fmt, value); \
+    check(fmt, p.s, n, ref); \
+} while (0)
+
+// compare one format against a fixed string
+#define CHECK_STRING(expected, fmt, ...) do { \
+    StringPrint p; \
+    size_t n = p.printf(fmt ## _fmt, ##__VA_ARGS__); \
+    check(fmt, p.s, n, expected); \
+} while (0)
+
+#define CHECK_INT(fmt) do { \
+    for (int32_t v : ivalues) \
+        CHECK_SNPRINTF(fmt, v); \
+} while (0)
+
+#define CHECK_UINT(fmt) do { \
+    for (uint32_t v : uvalues) \
+        CHECK_SNPRINTF(fmt, v); \
+} while (0)
+
+static const int32_t ivalues[] = { 0, 1, -1, 7, -42, 12345, -12345, 2147483647, -2147483647 - 1 };
+static const uint32_t uvalues[] = { 0, 1, 8, 15, 255, 0xdead, 0x80000000u, 0xffffffffu };
+
+int main(void)
+{
+    CHECK_INT("%d");
+    CHECK_INT("%i");
+    CHECK_INT("%5d");
+    CHECK_INT("%-5d|");
+    CHECK_INT("%05d");
+    CHECK_INT("%+d");
+    CHECK_INT("% d");
+    CHECK_INT("%.3d");
+    CHECK_INT("%.0d");
+    CHECK_INT("%8.3d");
+    CHECK_INT("%-+8.3d|");
+
+    CHECK_UINT("%u");
+    CHECK_UINT("%x");
+    CHECK_UINT("%X");
+    CHECK_UINT("%o");
+    CHECK_UINT("%#x");
+    CHECK_UINT("%#X");
+    CHECK_UINT("%#o");
+    CHECK_UINT("%#10x");
+    CHECK_UINT("%#010x");
+    CHECK_UINT("%-#10x|");
+    CHECK_UINT("%#.4x");
+    CHECK_UINT("%#.0x");
+    CHECK_UINT("%08X");
+    CHECK_UINT("%.0u");
+
+    CHECK_SNPRINTF("%c", 'A');
+    CHECK_SNPRINTF("%3c", 'A');
+    CHECK_SNPRINTF("%-3c|", 'A');
+    CHECK_SNPRINTF("%s", "hello");
+    CHECK_SNPRINTF("%8s", "hello");
+    CHECK_SNPRINTF("%-8s|", "hello");
+    CHECK_SNPRINTF("%.3s", "hello");
+    CHECK_STRING("100%", "%d%%", 100);
+
+    // # adds no prefix to zero, as in C
+    CHECK_STRING("0", "%#x", 0u);
+    CHECK_STRING("0", "%#X", 0u);
+    CHECK_STRING("  0", "%#3x", 0u);
+
+    // %p always has the prefix, like newlib
+    CHECK_STRING("0x0", "%p", (void*)0);
+    CHECK_STRING("0x20000000", "%p", (void*)0x20000000);
+
+    // %b is an extension
+    CHECK_STRING("101", "%b", 5u);
+    CHECK_STRING("00000101", "%08b", 5u);
+
+    // %f follows Print::print(double), rounding halves up
+    CHECK_STRING("3.141593", "%f", 3.14159265);
+    CHECK_STRING("3.14", "%.2f", 3.14159265);
+    CHECK_STRING("  -3.1", "%6.1f", -3.14159265);
+    CHECK_STRING("-003.1", "%06.1f", -3.14159265);
+    CHECK_STRING("+3", "%+.0f", 3.14159265);
+    CHECK_STRING("   nan", "%06f", (double)NAN);
+    CHECK_STRING("ovf", "%f", 1e10);
+
+    printf("%lu checks, %lu failures\n", checks, failures);
+    return failures ? 1 : 0;
+}
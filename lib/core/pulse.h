@@ -27,6 +27,8 @@ extern "C" {
  * or LOW, the type of pulse to measure.  Works on pulses from 2-3 microseconds
  * to 3 minutes in length, but must be called at least a few dozen microseconds
  * before the start of the pulse.
+ * This busy-waits for the whole measurement. For continuous, non-blocking
+ * measurement of a periodic signal use Timer::init_capture() instead.
  */
 uint32_t pulseIn(uint32_t pin, uint32_t state, uint32_t timeout);
 
@@ -17,6 +17,11 @@
 */
 
 #include "Arduino.h"
+#include "adc_calibration.h"
+
+#ifdef MICROS_USE_HWCLOCK
+#include "HwClock.h"
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -77,6 +82,11 @@ void init( void )
   // Clock TC/TCC for Pulse and Analog
   PM->APBCMASK.reg |= PM_APBCMASK_TCC0 | PM_APBCMASK_TCC1 | PM_APBCMASK_TCC2 | PM_APBCMASK_TC3 | PM_APBCMASK_TC4 | PM_APBCMASK_TC5 ;
 
+#ifdef MICROS_USE_HWCLOCK
+  // micros() reads TC4/TC5, start them before anything calls delay()
+  hwclock_init() ;
+#endif
+
   // Clock ADC/DAC for Analog
   PM->APBCMASK.reg |= PM_APBCMASK_ADC | PM_APBCMASK_DAC ;
 
@@ -111,6 +121,9 @@ void init( void )
 
   analogReference( AR_DEFAULT ) ; // Analog Reference is AREF pin (3.3v)
 
+  // Offset and gain correction saved by adc_calibration_store(), if any
+  adc_calibration_load() ;
+
   // Initialize DAC
   // Setting clock
   while ( GCLK->STATUS.reg & GCLK_STATUS_SYNCBUSY );
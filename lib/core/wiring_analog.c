@@ -53,20 +53,43 @@ static void syncTCC(Tcc* TCCx) {
   while (TCCx->SYNCBUSY.reg & TCC_SYNCBUSY_MASK);
 }
 
+// What the ADC was last set up for, so analogRead() only touches registers
+// that need to change. The ADC stays enabled between reads.
+static uint8_t _adcChannel = 0xff;    // MUXPOS, 0xff if unknown
+static uint8_t _adcRefsel = 0xff;     // REFCTRL.REFSEL
+static uint8_t _adcGain = 0xff;       // INPUTCTRL.GAIN
+static bool _adcEnabled = false;
+static bool _adcDiscard = true;       // next conversion follows a reference or gain change
+
+void analogReadInvalidate(void)
+{
+  _adcChannel = 0xff;
+  _adcRefsel = 0xff;
+  _adcGain = 0xff;
+  _adcEnabled = ADC->CTRLA.bit.ENABLE;
+  _adcDiscard = true;
+}
+
 void analogReadResolution(int res)
 {
+  uint32_t ressel;
   _readResolution = res;
   if (res > 10) {
-    ADC->CTRLB.bit.RESSEL = ADC_CTRLB_RESSEL_12BIT_Val;
+    ressel = ADC_CTRLB_RESSEL_12BIT_Val;
     _ADCResolution = 12;
   } else if (res > 8) {
-    ADC->CTRLB.bit.RESSEL = ADC_CTRLB_RESSEL_10BIT_Val;
+    ressel = ADC_CTRLB_RESSEL_10BIT_Val;
     _ADCResolution = 10;
   } else {
-    ADC->CTRLB.bit.RESSEL = ADC_CTRLB_RESSEL_8BIT_Val;
+    ressel = ADC_CTRLB_RESSEL_8BIT_Val;
     _ADCResolution = 8;
   }
+
   syncADC();
+  if (ADC->CTRLB.bit.RESSEL != ressel) {
+    ADC->CTRLB.bit.RESSEL = ressel;
+    syncADC();
+  }
 }
 
 void analogWriteResolution(int res)
@@ -93,95 +116,106 @@ static inline uint32_t mapResolution(uint32_t value, uint32_t from, uint32_t to)
  */
 void analogReference(eAnalogReference mode)
 {
-  syncADC();
+  uint32_t gain, refsel;
   switch (mode)
   {
     case AR_INTERNAL:
     case AR_INTERNAL2V23:
-      ADC->INPUTCTRL.bit.GAIN = ADC_INPUTCTRL_GAIN_1X_Val;      // Gain Factor Selection
-      ADC->REFCTRL.bit.REFSEL = ADC_REFCTRL_REFSEL_INTVCC0_Val; // 1/1.48 VDDANA = 1/1.48* 3V3 = 2.2297
+      gain = ADC_INPUTCTRL_GAIN_1X_Val;       // Gain Factor Selection
+      refsel = ADC_REFCTRL_REFSEL_INTVCC0_Val;  // 1/1.48 VDDANA = 1/1.48* 3V3 = 2.2297
       break;
 
     case AR_EXTERNAL:
-      ADC->INPUTCTRL.bit.GAIN = ADC_INPUTCTRL_GAIN_1X_Val;      // Gain Factor Selection
-      ADC->REFCTRL.bit.REFSEL = ADC_REFCTRL_REFSEL_AREFA_Val;
+      gain = ADC_INPUTCTRL_GAIN_1X_Val;       // Gain Factor Selection
+      refsel = ADC_REFCTRL_REFSEL_AREFA_Val;
       break;
 
     case AR_INTERNAL1V0:
-      ADC->INPUTCTRL.bit.GAIN = ADC_INPUTCTRL_GAIN_1X_Val;      // Gain Factor Selection
-      ADC->REFCTRL.bit.REFSEL = ADC_REFCTRL_REFSEL_INT1V_Val;   // 1.0V voltage reference
+      gain = ADC_INPUTCTRL_GAIN_1X_Val;       // Gain Factor Selection
+      refsel = ADC_REFCTRL_REFSEL_INT1V_Val;    // 1.0V voltage reference
       break;
 
     case AR_INTERNAL1V65:
-      ADC->INPUTCTRL.bit.GAIN = ADC_INPUTCTRL_GAIN_1X_Val;      // Gain Factor Selection
-      ADC->REFCTRL.bit.REFSEL = ADC_REFCTRL_REFSEL_INTVCC1_Val; // 1/2 VDDANA = 0.5* 3V3 = 1.65V
+      gain = ADC_INPUTCTRL_GAIN_1X_Val;       // Gain Factor Selection
+      refsel = ADC_REFCTRL_REFSEL_INTVCC1_Val;  // 1/2 VDDANA = 0.5* 3V3 = 1.65V
       break;
 
     case AR_DEFAULT:
     default:
-      ADC->INPUTCTRL.bit.GAIN = ADC_INPUTCTRL_GAIN_DIV2_Val;
-      ADC->REFCTRL.bit.REFSEL = ADC_REFCTRL_REFSEL_INTVCC1_Val; // 1/2 VDDANA = 0.5* 3V3 = 1.65V
+      gain = ADC_INPUTCTRL_GAIN_DIV2_Val;
+      refsel = ADC_REFCTRL_REFSEL_INTVCC1_Val;  // 1/2 VDDANA = 0.5* 3V3 = 1.65V
       break;
   }
+
+  if (gain == _adcGain && refsel == _adcRefsel)
+    return;
+
+  syncADC();
+  ADC->INPUTCTRL.bit.GAIN = gain;
+  ADC->REFCTRL.bit.REFSEL = refsel;
+  _adcGain = gain;
+  _adcRefsel = refsel;
+
+  // The first conversion after the reference is changed must not be used
+  _adcDiscard = true;
+}
+
+// true if the pin is already muxed to the ADC, so pinPeripheral() can be skipped
+static inline bool pinIsAnalog(uint32_t pin)
+{
+  const PortGroup *port = &PORT->Group[g_APinDescription[pin].ulPort];
+  const uint32_t bit = g_APinDescription[pin].ulPin;
+  if (!port->PINCFG[bit].bit.PMUXEN)
+    return false;
+  const uint32_t pmux = port->PMUX[bit >> 1].reg;
+  return ((bit & 1) ? (pmux >> 4) : (pmux & 0xf)) == PIO_ANALOG;
 }
 
+/*
+ * The ADC is left enabled with the last pin selected, so a repeated read is
+ * one conversion. The mux, pin and DAC are only written when they change, and
+ * a conversion is only discarded after analogReference() changed something.
+ */
 uint32_t analogRead(uint32_t pin)
 {
   uint32_t valueRead = 0;
+  const uint32_t channel = g_APinDescription[pin].ulADCChannelNumber;
 
-#if 0
-  if (pin < A0) {
-    pin += A0;
-  }
-#endif
-
-  pinPeripheral(pin, PIO_ANALOG);
+  if (!pinIsAnalog(pin))
+    pinPeripheral(pin, PIO_ANALOG);
 
   // Disable DAC, if analogWrite() was used previously to enable the DAC
-  if ((g_APinDescription[pin].ulADCChannelNumber == ADC_Channel0) || (g_APinDescription[pin].ulADCChannelNumber == DAC_Channel0)) {
+  if ((channel == ADC_Channel0 || channel == DAC_Channel0) && DAC->CTRLA.bit.ENABLE) {
     syncDAC();
     DAC->CTRLA.bit.ENABLE = 0x00; // Disable DAC
-    //DAC->CTRLB.bit.EOEN = 0x00; // The DAC output is turned off.
     syncDAC();
   }
 
-  syncADC();
-  ADC->INPUTCTRL.bit.MUXPOS = g_APinDescription[pin].ulADCChannelNumber; // Selection for the positive ADC input
-
-  // Control A
-  /*
-   * Bit 1 ENABLE: Enable
-   *   0: The ADC is disabled.
-   *   1: The ADC is enabled.
-   * Due to synchronization, there is a delay from writing CTRLA.ENABLE until the peripheral is enabled/disabled. The
-   * value written to CTRL.ENABLE will read back immediately and the Synchronization Busy bit in the Status register
-   * (STATUS.SYNCBUSY) will be set. STATUS.SYNCBUSY will be cleared when the operation is complete.
-   *
-   * Before enabling the ADC, the asynchronous clock source must be selected and enabled, and the ADC reference must be
-   * configured. The first conversion after the reference is changed must not be used.
-   */
-  syncADC();
-  ADC->CTRLA.bit.ENABLE = 0x01;             // Enable ADC
+  if (channel != _adcChannel) {
+    syncADC();
+    ADC->INPUTCTRL.bit.MUXPOS = channel; // Selection for the positive ADC input
+    _adcChannel = channel;
+  }
 
-  // Start conversion
-  syncADC();
-  ADC->SWTRIG.bit.START = 1;
+  if (!_adcEnabled) {
+    syncADC();
+    ADC->CTRLA.bit.ENABLE = 0x01;             // Enable ADC
+    _adcEnabled = true;
+  }
 
-  // Clear the Data Ready flag
-  ADC->INTFLAG.reg = ADC_INTFLAG_RESRDY;
+  if (_adcDiscard) {
+    syncADC();
+    ADC->SWTRIG.bit.START = 1;
+    while (ADC->INTFLAG.bit.RESRDY == 0);
+    _adcDiscard = false;
+  }
 
-  // Start conversion again, since The first conversion after the reference is changed must not be used.
+  ADC->INTFLAG.reg = ADC_INTFLAG_RESRDY;
   syncADC();
   ADC->SWTRIG.bit.START = 1;
-
-  // Store the value
   while (ADC->INTFLAG.bit.RESRDY == 0);   // Waiting for conversion to complete
   valueRead = ADC->RESULT.reg;
 
-  syncADC();
-  ADC->CTRLA.bit.ENABLE = 0x00;             // Disable ADC
-  syncADC();
-
   return mapResolution(valueRead, _ADCResolution, _readResolution);
 }
 
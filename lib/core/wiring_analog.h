@@ -70,6 +70,13 @@ extern uint32_t analogRead( uint32_t ulPin ) ;
  */
 extern void analogReadResolution(int res);
 
+/*
+ * \brief Forget the ADC state cached by analogRead(). Call after reconfiguring
+ * the ADC directly, analogRead() then reprograms the mux and discards one
+ * conversion, and the next analogReference() call writes its registers.
+ */
+extern void analogReadInvalidate(void);
+
 /*
  * \brief Set the resolution of analogWrite parameters. Default is 8 bits (range from 0 to 255).
  *
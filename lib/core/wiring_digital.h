@@ -25,8 +25,62 @@
 
 #include "WVariant.h"
 
-#define PORT_SET_FAST(_port, _pin) do { PORT->Group[_port].OUTSET.reg = 1UL << (_pin); } while (0)
-#define PORT_CLR_FAST(_port, _pin) do { PORT->Group[_port].OUTCLR.reg = 1UL << (_pin); } while (0)
+/*
+ * Direct port access through the IOBUS alias of PORT, which the CPU reaches in
+ * a single cycle rather than through the APB bridge. Only the CPU can use the
+ * IOBUS, DMA and the configuration registers (DIR, PINCFG, PMUX) still go
+ * through PORT. None of these check that the port or mask is valid.
+ *
+ * IN is read through PORT, not the IOBUS. An IOBUS read can't wait for IN to
+ * resynchronize, so it returns stale data unless the pin has continuous
+ * sampling enabled in CTRL, which nothing here sets up.
+ */
+#define PORT_SET_FAST(_port, _pin) do { PORT_IOBUS->Group[_port].OUTSET.reg = 1UL << (_pin); } while (0)
+#define PORT_CLR_FAST(_port, _pin) do { PORT_IOBUS->Group[_port].OUTCLR.reg = 1UL << (_pin); } while (0)
+#define PORT_TGL_FAST(_port, _pin) do { PORT_IOBUS->Group[_port].OUTTGL.reg = 1UL << (_pin); } while (0)
+
+static inline void portOutSet(uint32_t port, uint32_t mask) { PORT_IOBUS->Group[port].OUTSET.reg = mask; }
+static inline void portOutClear(uint32_t port, uint32_t mask) { PORT_IOBUS->Group[port].OUTCLR.reg = mask; }
+static inline void portOutToggle(uint32_t port, uint32_t mask) { PORT_IOBUS->Group[port].OUTTGL.reg = mask; }
+static inline uint32_t portOutRead(uint32_t port) { return PORT_IOBUS->Group[port].OUT.reg; }
+static inline uint32_t portInRead(uint32_t port) { return PORT->Group[port].IN.reg; }
+
+/**
+ * \brief Set the pins in mask to the corresponding bits of value with one write to OUT, so they all change
+ * on the same clock cycle. Pins outside of mask are unchanged.
+ *
+ * OUT is read-modified-written with interrupts disabled so that an interrupt handler writing other pins of
+ * the same port isn't undone.
+ */
+static inline void portOutWrite(uint32_t port, uint32_t mask, uint32_t value)
+{
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  PORT_IOBUS->Group[port].OUT.reg = (PORT_IOBUS->Group[port].OUT.reg & ~mask) | (value & mask);
+  __set_PRIMASK(primask);
+}
+
+/**
+ * \brief digitalWrite() through the IOBUS and digitalRead(), without the PIO_NOT_A_PIN check or the pull-up
+ * handling for input pins. The pin must already be configured with pinMode().
+ */
+static inline void digitalWriteFast(uint32_t ulPin, uint32_t ulVal)
+{
+  if (ulVal)
+    portOutSet(g_APinDescription[ulPin].ulPort, 1ul << g_APinDescription[ulPin].ulPin);
+  else
+    portOutClear(g_APinDescription[ulPin].ulPort, 1ul << g_APinDescription[ulPin].ulPin);
+}
+
+static inline void digitalToggleFast(uint32_t ulPin)
+{
+  portOutToggle(g_APinDescription[ulPin].ulPort, 1ul << g_APinDescription[ulPin].ulPin);
+}
+
+static inline int digitalReadFast(uint32_t ulPin)
+{
+  return (portInRead(g_APinDescription[ulPin].ulPort) >> g_APinDescription[ulPin].ulPin) & 1;
+}
 
 /**
  * \brief Configures the specified pin to behave either as an input or an output. See the description of digital pins for details.
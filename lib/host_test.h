@@ -0,0 +1,42 @@
+/*
+ * host_test.h: check macro and summary shared by the console test programs
+ * (the *_test.cc files next to the libraries they test). Include it as
+ * "../host_test.h" so the tests still build with one g++ command in their own
+ * directory.
+ *
+ * CHECK(cond, fmt, ...) counts a failure when cond is false and prints the
+ * first few with the line number and a printf-style message. A test can print
+ * more about the case being checked by defining CHECK_CONTEXT() before
+ * including this. check_result() prints the total and gives main()'s exit
+ * status.
+ */
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdio.h>
+
+#define CHECK_MAX_PRINTED 20
+
+#ifndef CHECK_CONTEXT
+#define CHECK_CONTEXT()
+#endif
+
+static unsigned long failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond) && failures++ < CHECK_MAX_PRINTED) { \
+        printf("FAIL line %d: ", __LINE__); \
+        CHECK_CONTEXT(); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+    } \
+} while (0)
+
+static inline int check_result(void)
+{
+    printf("%lu failures\n", failures);
+    return failures ? 1 : 0;
+}
+
+#endif // HOST_TEST_H
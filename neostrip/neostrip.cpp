@@ -18,10 +18,14 @@
  ******************************************************************************/
 
 #include "Arduino.h"
-#include "DigitalIO.h"
+#include "FastIO.h"
 #include "Neostrip.h"
 #include "MPR121.h"
+#include "Quadrature.h"
 #include "Wire.h"
+#ifdef PROFILE
+#include "Profiler.h"
+#endif
 #include "wiring_private.h"
 
 #define STRIP_LENGTH 8
@@ -35,40 +39,20 @@ Neostrip<STRIP_LENGTH> ns(SPI);
 TwoWire i2c(&sercom2, KEYPAD_SDA_PIN, KEYPAD_SCL_PIN);
 MPR121 keypad(i2c);
 
-DigitalOut blue_led(13, HIGH);
-DigitalIn keypad_irq(KEYPAD_IRQ_PIN, INPUT_PULLUP);
-DigitalIn rpg_a(6);
-DigitalIn rpg_b(7);
-DigitalIn rpg_pb(9, INPUT_PULLUP);
+// FastIn/FastOut since these are all used from interrupts
+FastOut<13> blue_led(HIGH);
+FastIn<KEYPAD_IRQ_PIN> keypad_irq(INPUT_PULLUP);
+FastIn<9> rpg_pb(INPUT_PULLUP);
 
-static volatile uint8_t rpg_state;
-static volatile int brightness = (10 * 255) / 100;
+// RPG A and B channels, plain inputs like before
+Quadrature rpg(6, 7, INPUT);
+
+static int brightness = (10 * 255) / 100;
 static volatile bool invert = false;
 static volatile bool keypad_event = false;
 
 static const int direction = 1;
 
-static inline void read_rpg(void)
-{
-    rpg_state = (rpg_a << 1) | rpg_b;
-}
-
-static void rpg_isr(void)
-{
-    __disable_irq();
-    uint8_t old_state = rpg_state;
-    read_rpg();
-    if ((old_state ^ (rpg_state<<1)) & 2)
-    {
-        brightness += BRIGHTNESS_STEP;
-    }
-    else
-    {
-        brightness -= BRIGHTNESS_STEP;
-    }
-    __enable_irq();
-}
-
 static void rpg_pb_isr(void)
 {
     //direction *= -1;
@@ -81,31 +65,20 @@ static void keypad_isr(void)
     blue_led = 1;
 }
 
-static inline uint8_t clamp_brightness(void)
+static inline uint8_t update_brightness(void)
 {
-    __disable_irq();
-    int b = brightness;
-    if (b < 0)
-    {
-        b = brightness = 0;
-    }
-    if (b > 255)
-    {
-        b = brightness = 255;
-    }
-    __enable_irq();
-    return (uint8_t)b;
+    brightness += rpg.delta() * BRIGHTNESS_STEP;
+    if (brightness < 0)
+        brightness = 0;
+    else if (brightness > 255)
+        brightness = 255;
+    return (uint8_t)brightness;
 }
 
 void setup(void)
 {
     blue_led = 1;
-    read_rpg();
-
-    rpg_a.add_interrupt(rpg_isr, CHANGE);
-    rpg_a.set_interrupt_filter(true);
-    rpg_b.add_interrupt(rpg_isr, CHANGE);
-    rpg_b.set_interrupt_filter(true);
+    rpg.begin();
 
     rpg_pb.add_interrupt(rpg_pb_isr, FALLING);
     keypad_irq.add_interrupt(keypad_isr, FALLING);
@@ -123,6 +96,11 @@ void setup(void)
     pinPeripheral(KEYPAD_SCL_PIN, PIO_SERCOM_ALT);
     keypad.init(false);
 
+#ifdef PROFILE
+    // send P over SerialUSB to dump, then run scripts/profile-report.py
+    profiler_start();
+#endif
+
     blue_led = 0;
 }
 
@@ -192,8 +170,8 @@ void loop(void)
             ns.set_color(i, BLACK);
     }
 
-    ns.set_brightness(clamp_brightness());
-    //SerialUSB.printf("brightness %d, rpg %u\n", brightness, rpg_state);
+    ns.set_brightness(update_brightness());
+    //SerialUSB.printf("brightness %d, rpg %d\n", brightness, (int)rpg.count());
     ns.write(false); // don't wait for tranfer complete (long delay soon)
 
     for (unsigned i = 0; i < STRIP_LENGTH; i++)
@@ -207,5 +185,10 @@ void loop(void)
             basehue = N_STEPS-1;
     }
 
+#ifdef PROFILE
+    if (SerialUSB.read() == 'P')
+        profiler_dump(SerialUSB);
+#endif
+
     delay(17);
 }
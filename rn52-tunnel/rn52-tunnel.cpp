@@ -19,10 +19,19 @@
 
 #include "Arduino.h"
 #include "DigitalIO.h"
+#include "LineReader.h"
 
 DigitalOut blue_led(13, HIGH);
 DigitalOut gpio9(17, HIGH);
 
+static char cmdbuf[16];
+static LineReader cmd_reader(cmdbuf, true);
+
+// show the prompt once the RN52 has been quiet for this long
+static constexpr unsigned long PROMPT_DELAY_MS = 50;
+static unsigned long last_activity = 0;
+static bool prompt_pending = true;
+
 #if 0
 void Serial1_IrqHook(void)
 {
@@ -52,19 +61,28 @@ void setup(void)
 
 void loop(void)
 {
-    while (Serial1.available())
+    uint8_t buf[64];
+    size_t count;
+    while ((count = Serial1.readAvailable(buf, sizeof(buf))) != 0)
     {
-        while (Serial1.available())
-            SerialUSB.write(Serial1.read());
-        delay(10);
+        SerialUSB.write(buf, count);
+        last_activity = millis();
     }
 
-    SerialUSB.write("> ");
-    char cmdbuf[16];
-    size_t cmdlen = SerialUSB.readLine(cmdbuf, sizeof(cmdbuf), true);
-    if (cmdlen) {
-        //SerialUSB.printf("count=%u buf='%s'\r\n", cmdlen, cmdbuf);
-        Serial1.printf("%s\r", cmdbuf);
-        delay(50);
+    if (prompt_pending && (millis() - last_activity) >= PROMPT_DELAY_MS)
+    {
+        SerialUSB.write("> ");
+        prompt_pending = false;
+    }
+
+    if (cmd_reader.poll(SerialUSB))
+    {
+        if (cmd_reader.length())
+        {
+            //SerialUSB.printf("count=%u buf='%s'\r\n", cmd_reader.length(), cmdbuf);
+            Serial1.printf("%s\r"_fmt, cmdbuf);
+        }
+        last_activity = millis();
+        prompt_pending = true;
     }
 }
@@ -0,0 +1,181 @@
+#!/usr/bin/env python
+# binlog-decode.py: decode BinLog binary frames using format strings from the ELF
+#
+# Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+# SPDX-License-Identifier: GPL-3.0-or-later
+#
+# Usage: scripts/binlog-decode.py obj/sketch/sketch.elf [/dev/ttyACM0 | capture.bin | -]
+#
+# Frame format (see lib/BinLog/BinLog.cpp), all fields little-endian:
+#   0xA5, nargs, 3-byte ID, 4-byte micros() timestamp, nargs*4-byte args, checksum
+# The ID is the address of the format string in the .binlog_fmt section.
+
+from __future__ import print_function, division
+
+import sys, os, re, struct
+from argparse import ArgumentParser
+
+FRAME_SYNC = 0xa5
+ID_DROPPED = 0xffffff
+MAX_ARGS = 8
+
+class ELFSections(object):
+    """ Just enough of an ELF32 little-endian parser to read section contents """
+    def __init__(self, filename):
+        with open(filename, 'rb') as fp:
+            data = fp.read()
+        if data[:4] != b'\x7fELF' or bytearray(data)[4] != 1:
+            raise RuntimeError('%s is not a 32-bit ELF file'%filename)
+
+        shoff, = struct.unpack_from('<I', data, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from('<HHH', data, 0x2e)
+
+        headers = []
+        for i in range(shnum):
+            name, stype, flags, addr, offset, size = struct.unpack_from('<IIIIII', data, shoff + i*shentsize)
+            headers.append((name, stype, addr, offset, size))
+
+        strtab_off, strtab_size = headers[shstrndx][3], headers[shstrndx][4]
+        strtab = data[strtab_off:strtab_off+strtab_size]
+
+        # name -> (address, contents). SHT_NOBITS (8) sections have no contents
+        self.sections = {}
+        for name, stype, addr, offset, size in headers:
+            sname = strtab[name:strtab.index(b'\0', name)].decode()
+            contents = data[offset:offset+size] if stype != 8 else b''
+            self.sections[sname] = (addr, contents)
+
+    def get(self, name):
+        return self.sections.get(name, (0, b''))
+
+def cstring(data, offset):
+    end = data.find(b'\0', offset)
+    if end < 0:
+        end = len(data)
+    return data[offset:end].decode('utf-8', 'replace')
+
+# printf conversion spec. Length modifiers are dropped since every argument is a
+# 32-bit word, and * widths aren't supported.
+CONV_RE = re.compile(r'%([-+ #0]*)(\d*)(?:\.(\d*))?(hh|h|ll|l|j|z|t|L)?([diouxXeEfFgGaAcsp%])')
+
+class Decoder(object):
+    def __init__(self, elf):
+        self.fmt_addr, self.fmt_data = elf.get('.binlog_fmt')
+        if not self.fmt_data:
+            raise RuntimeError('no .binlog_fmt section in ELF, is BINLOG used?')
+        self.text_addr, self.text_data = elf.get('.text')
+
+    def format_string(self, fmt_id):
+        offset = fmt_id - self.fmt_addr
+        if offset < 0 or offset >= len(self.fmt_data):
+            return None
+        return cstring(self.fmt_data, offset)
+
+    def flash_string(self, addr):
+        offset = addr - self.text_addr
+        if 0 <= offset < len(self.text_data):
+            return cstring(self.text_data, offset)
+        return '<0x%08x>'%addr
+
+    def format(self, fmt, args):
+        args = list(args)
+        def convert(m):
+            flags, width, prec, length, conv = m.groups()
+            if conv == '%':
+                return '%'
+            if not args:
+                return '<missing>'
+            word = args.pop(0)
+            spec = '%' + flags + width + ('.' + prec if prec is not None else '')
+            if conv in 'di':
+                if length == 'hh':
+                    word = struct.unpack('<b', struct.pack('<B', word & 0xff))[0]
+                elif length == 'h':
+                    word = struct.unpack('<h', struct.pack('<H', word & 0xffff))[0]
+                else:
+                    word = struct.unpack('<i', struct.pack('<I', word))[0]
+                return (spec + 'd')%word
+            if conv == 'u':
+                return (spec + 'd')%word
+            if conv in 'oxX':
+                return (spec + conv)%word
+            if conv == 'c':
+                return (spec + 'c')%chr(word & 0xff)
+            if conv == 'p':
+                return '0x%08x'%word
+            if conv == 's':
+                return (spec + 's')%self.flash_string(word)
+            # floating point, stored as a single-precision float
+            value = struct.unpack('<f', struct.pack('<I', word))[0]
+            return (spec + conv.replace('a', 'g').replace('A', 'G'))%value
+        return CONV_RE.sub(convert, fmt)
+
+    def decode(self, fmt_id, timestamp, args):
+        if fmt_id == ID_DROPPED:
+            text = '*** %u entries dropped ***'%args[0]
+        else:
+            fmt = self.format_string(fmt_id)
+            if fmt is None:
+                text = '<unknown format ID 0x%06x> %s'%(fmt_id, ' '.join('0x%08x'%a for a in args))
+            else:
+                text = self.format(fmt, args).rstrip('\r\n')
+        return '[%10.6f] %s'%(timestamp / 1e6, text)
+
+def read_frames(fp):
+    """ generator yielding (id, timestamp, args) tuples, resyncing on bad frames """
+    buf = bytearray()
+    # read1 returns whatever is available rather than blocking for a full buffer
+    read = getattr(fp, 'read1', fp.read)
+    while True:
+        chunk = read(256)
+        if not chunk:
+            return
+        buf.extend(bytearray(chunk))
+        while len(buf) >= 10:
+            if buf[0] != FRAME_SYNC:
+                del buf[0]
+                continue
+            nargs = buf[1]
+            if nargs > MAX_ARGS:
+                del buf[0]
+                continue
+            length = 10 + 4*nargs
+            if len(buf) < length:
+                break
+            if (sum(buf[1:length-1]) & 0xff) != buf[length-1]:
+                del buf[0]
+                continue
+            fmt_id = buf[2] | (buf[3] << 8) | (buf[4] << 16)
+            timestamp, = struct.unpack_from('<I', bytes(buf), 5)
+            args = struct.unpack_from('<%dI'%nargs, bytes(buf), 9)
+            del buf[:length]
+            yield fmt_id, timestamp, args
+
+def open_input(name):
+    if name == '-':
+        return getattr(sys.stdin, 'buffer', sys.stdin)
+    fp = open(name, 'rb', 0)
+    if os.isatty(fp.fileno()):
+        import tty
+        tty.setraw(fp.fileno())
+    return fp
+
+if __name__ == '__main__':
+    parser = ArgumentParser(description='Decode BinLog output')
+    parser.add_argument('elf', metavar='ELF', help='ELF file of the running firmware (e.g. obj/sketch/sketch.elf)')
+    parser.add_argument('input', metavar='INPUT', nargs='?', default='-',
+                        help='serial port or capture file to read, default stdin')
+    args = parser.parse_args()
+
+    try:
+        decoder = Decoder(ELFSections(args.elf))
+        fp = open_input(args.input)
+    except Exception as e:
+        sys.exit('Error: %s'%e)
+
+    try:
+        for fmt_id, timestamp, fargs in read_frames(fp):
+            print(decoder.decode(fmt_id, timestamp, fargs))
+            sys.stdout.flush()
+    except KeyboardInterrupt:
+        pass
@@ -19,7 +19,7 @@ class ELFSize(object):
         sizedata = check_output(cmd, universal_newlines=True)
 
         # Example output, we care about the size column
-        # obj/ptctest.elf  :
+        # obj/ptctest/ptctest.elf  :
         # section              size        addr
         # .text               10148        8192
         # .data                 208   536870912
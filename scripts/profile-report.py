@@ -0,0 +1,197 @@
+#!/usr/bin/env python
+# profile-report.py: print a flat profile from profiler_dump() output
+#
+# Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+# SPDX-License-Identifier: GPL-3.0-or-later
+#
+# Usage: scripts/profile-report.py obj/sketch/sketch.elf [capture.txt | /dev/ttyACM0 | -]
+#        scripts/profile-report.py obj/sketch/sketch.map [capture.txt | /dev/ttyACM0 | -]
+#
+# Dump format (see lib/Profiler/Profiler.h), anything outside the
+# # profile/# end lines is ignored so a whole serial log can be passed in:
+#   # profile hz=<hz> samples=<n> dropped=<n>
+#   <pc hex> <count>
+#   # end
+# PCs are resolved with nm(1) from the ELF ($NM, default arm-none-eabi-nm), or
+# from the linker map file, which works without binutils but leaves C++ names
+# mangled. The map file relies on -ffunction-sections for static functions,
+# which only show up as .text.<name> input sections.
+
+from __future__ import print_function, division
+
+import sys, os, re, bisect
+from argparse import ArgumentParser
+from subprocess import check_output, CalledProcessError
+
+HEADER_RE = re.compile(r'# profile hz=(\d+) samples=(\d+) dropped=(\d+)')
+SAMPLE_RE = re.compile(r'([0-9a-fA-F]{8}) (\d+)$')
+
+class Symbols(object):
+    """ sorted address -> function name lookup """
+    def __init__(self, syms):
+        # syms is a list of (address, size or None, name)
+        syms = sorted(syms, key=lambda s: s[0])
+        self.addrs = [s[0] for s in syms]
+        self.syms = syms
+
+    def lookup(self, pc):
+        i = bisect.bisect_right(self.addrs, pc) - 1
+        if i < 0:
+            return None
+        addr, size, name = self.syms[i]
+        if size is not None and pc >= addr + size:
+            return None
+        return name
+
+def read_nm(filename):
+    nm = os.environ.get('NM', 'arm-none-eabi-nm')
+    out = check_output([nm, '--defined-only', '-S', '-C', filename], universal_newlines=True)
+    syms = []
+    for line in out.splitlines():
+        # "<addr> <size> <type> <name>", size is missing for some asm symbols
+        fields = line.split(None, 3)
+        if len(fields) == 4 and fields[2] in 'tTwW':
+            addr, size, name = int(fields[0], 16), int(fields[1], 16), fields[3]
+        elif len(fields) == 3 and fields[1] in 'tTwW':
+            addr, size, name = int(fields[0], 16), None, fields[2]
+        else:
+            continue
+        # thumb function symbols have bit 0 set
+        syms.append((addr & ~1, size, name))
+    return Symbols(syms)
+
+def read_map(filename):
+    # Input sections look like
+    #  .text.loop     0x00002134       0x1c obj/sketch/sketch.o
+    # with long names wrapping the address to the next line, and global
+    # symbols are listed after their section as
+    #                 0x00002134                loop
+    section_re = re.compile(r'\s*\.text\.(\S+)?\s*$|\s*\.text\.(\S+)\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)')
+    addr_re = re.compile(r'\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s')
+    symbol_re = re.compile(r'\s+0x([0-9a-f]+)\s+([A-Za-z_][^\s=]*)\s*$')
+
+    # address -> [size, name], a symbol at the start of a section replaces
+    # the section name but keeps its size
+    syms = {}
+    def add(addr, size, name):
+        if size is not None:
+            if size:
+                syms[addr] = [size, name]
+        elif addr in syms:
+            syms[addr][1] = name
+        else:
+            syms[addr] = [None, name]
+
+    pending = None
+    in_text = False
+    with open(filename) as fp:
+        for line in fp:
+            if line.startswith('.text'):
+                in_text = True
+            elif line.startswith('.') or line.startswith('OUTPUT'):
+                in_text = False
+            if not in_text:
+                continue
+
+            if pending is not None:
+                m = addr_re.match(line)
+                if m:
+                    add(int(m.group(1), 16), int(m.group(2), 16), pending)
+                pending = None
+                continue
+
+            m = section_re.match(line)
+            if m:
+                if m.group(2):
+                    add(int(m.group(3), 16), int(m.group(4), 16), m.group(2))
+                else:
+                    pending = m.group(1)
+                continue
+
+            m = symbol_re.match(line)
+            if m:
+                add(int(m.group(1), 16), None, m.group(2))
+
+    return Symbols([(addr, size, name) for addr, (size, name) in syms.items()])
+
+def read_dump(fp):
+    """ return (hz, samples, dropped, {pc: count}) for the first dump in the input """
+    header = None
+    counts = {}
+    for line in fp:
+        if isinstance(line, bytes):
+            line = line.decode('utf-8', 'replace')
+        line = line.strip()
+
+        m = HEADER_RE.match(line)
+        if m:
+            header = [int(x) for x in m.groups()]
+            counts = {}
+            continue
+        if header is None:
+            continue
+        if line == '# end':
+            return header[0], header[1], header[2], counts
+
+        m = SAMPLE_RE.match(line)
+        if m:
+            pc = int(m.group(1), 16)
+            counts[pc] = counts.get(pc, 0) + int(m.group(2))
+    return None
+
+def open_input(name):
+    if name == '-':
+        return sys.stdin
+    fp = open(name, 'r')
+    if os.isatty(fp.fileno()):
+        import tty
+        tty.setraw(fp.fileno())
+    return fp
+
+if __name__ == '__main__':
+    parser = ArgumentParser(description='Print a flat profile from profiler_dump() output')
+    parser.add_argument('symfile', metavar='ELF|MAP',
+                        help='ELF or linker map file of the running firmware (obj/sketch/sketch.elf or .map)')
+    parser.add_argument('input', metavar='INPUT', nargs='?', default='-',
+                        help='serial port or capture file to read, default stdin')
+    parser.add_argument('-n', '--top', type=int, default=0, help='only print the top N functions')
+    parser.add_argument('-p', '--pcs', action='store_true', help='list the sampled PCs in each function')
+    args = parser.parse_args()
+
+    try:
+        if args.symfile.endswith('.map'):
+            symbols = read_map(args.symfile)
+        else:
+            symbols = read_nm(args.symfile)
+        fp = open_input(args.input)
+    except (OSError, IOError, CalledProcessError) as e:
+        sys.exit('Error: %s'%e)
+
+    try:
+        dump = read_dump(fp)
+    except KeyboardInterrupt:
+        dump = None
+    if dump is None:
+        sys.exit('Error: no profile dump found')
+    hz, samples, dropped, counts = dump
+
+    funcs = {}
+    for pc, count in counts.items():
+        name = symbols.lookup(pc) or '<unknown>'
+        total, pcs = funcs.get(name, (0, []))
+        pcs.append((count, pc))
+        funcs[name] = (total + count, pcs)
+    if dropped:
+        funcs['<dropped, table full>'] = (dropped, [])
+
+    secs = samples / hz if hz else 0
+    print('%d samples at %d Hz (%.1f s)'%(samples, hz, secs))
+    print('%8s %7s  %s'%('samples', '%', 'function'))
+    ranked = sorted(funcs.items(), key=lambda f: f[1][0], reverse=True)
+    if args.top:
+        ranked = ranked[:args.top]
+    for name, (total, pcs) in ranked:
+        print('%8d %6.2f%%  %s'%(total, 100 * total / samples if samples else 0, name))
+        if args.pcs:
+            for count, pc in sorted(pcs, reverse=True):
+                print('%8d %7s    0x%08x'%(count, '', pc))
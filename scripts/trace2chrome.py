@@ -0,0 +1,128 @@
+#!/usr/bin/env python
+# trace2chrome.py: convert a trace_dump() capture to Chrome trace JSON
+#
+# Copyright (C) 2019 Allen Wild <allenwild93@gmail.com>
+# SPDX-License-Identifier: GPL-3.0-or-later
+#
+# Usage: scripts/trace2chrome.py [capture.txt | /dev/ttyACM0 | -] [-o trace.json]
+#
+# Dump format (see lib/core/Trace.h), anything outside the # trace/# end
+# lines is ignored so a whole serial log can be passed in:
+#   # trace f_cpu=<hz> events=<n> overwritten=<n> dropped=<n>
+#   N <id> <name>
+#   <ms> <cycles> <B|E|I> <id>
+#   # end
+# Each ID gets its own row, so regions that overlap without nesting (e.g. an
+# ISR and the code it interrupts) still display correctly. The result opens in
+# chrome://tracing or https://ui.perfetto.dev
+
+from __future__ import print_function, division
+
+import sys, os, re, json
+from argparse import ArgumentParser
+
+HEADER_RE = re.compile(r'# trace f_cpu=(\d+) events=(\d+) overwritten=(\d+) dropped=(\d+)')
+NAME_RE = re.compile(r'N (\d+) (.*)$')
+EVENT_RE = re.compile(r'(\d+) (\d+) ([BEI]) (\d+)$')
+
+def read_dumps(fp):
+    """ generator yielding (f_cpu, names, events, lost) for each dump in the input """
+    dump = None
+    for line in fp:
+        if isinstance(line, bytes):
+            line = line.decode('utf-8', 'replace')
+        line = line.strip()
+
+        m = HEADER_RE.match(line)
+        if m:
+            f_cpu, _, overwritten, dropped = [int(x) for x in m.groups()]
+            dump = (f_cpu, {}, [], overwritten + dropped)
+            continue
+        if dump is None:
+            continue
+        if line == '# end':
+            yield dump
+            dump = None
+            continue
+
+        m = NAME_RE.match(line)
+        if m:
+            dump[1][int(m.group(1))] = m.group(2)
+            continue
+        m = EVENT_RE.match(line)
+        if m:
+            ms, cycles, etype, eid = m.groups()
+            dump[2].append((int(ms), int(cycles), etype, int(eid)))
+
+def convert(f_cpu, names, events, lost):
+    """ return a list of Chrome trace event dicts """
+    cycles_per_us = f_cpu / 1e6
+    out = []
+    open_ids = set()
+
+    for ms, cycles, etype, eid in events:
+        name = names.get(eid, 'id%d'%eid)
+        ts = ms * 1000 + cycles / cycles_per_us
+        if etype == 'E':
+            # the begin may have been overwritten in the ring
+            if eid not in open_ids:
+                continue
+            open_ids.discard(eid)
+        elif etype == 'B':
+            open_ids.add(eid)
+
+        ev = {'name': name, 'ph': etype, 'ts': ts, 'pid': 0, 'tid': eid}
+        if etype == 'I':
+            ev['ph'] = 'i'
+            ev['s'] = 't'
+        out.append(ev)
+
+    for eid in sorted(names):
+        out.append({'name': 'thread_name', 'ph': 'M', 'pid': 0, 'tid': eid,
+                    'args': {'name': names[eid]}})
+    if lost:
+        out.append({'name': 'process_labels', 'ph': 'M', 'pid': 0,
+                    'args': {'labels': '%d events lost'%lost}})
+    return out
+
+def open_input(name):
+    if name == '-':
+        return sys.stdin
+    fp = open(name, 'r')
+    if os.isatty(fp.fileno()):
+        import tty
+        tty.setraw(fp.fileno())
+    return fp
+
+if __name__ == '__main__':
+    parser = ArgumentParser(description='Convert trace_dump() output to Chrome trace JSON')
+    parser.add_argument('input', metavar='INPUT', nargs='?', default='-',
+                        help='serial port or capture file to read, default stdin')
+    parser.add_argument('-o', '--output', default='-', help='JSON file to write, default stdout')
+    parser.add_argument('-a', '--all', action='store_true',
+                        help='convert every dump in the input rather than only the first')
+    args = parser.parse_args()
+
+    try:
+        fp = open_input(args.input)
+    except Exception as e:
+        sys.exit('Error: %s'%e)
+
+    trace = []
+    try:
+        for dump in read_dumps(fp):
+            trace.extend(convert(*dump))
+            if not args.all:
+                break
+    except KeyboardInterrupt:
+        pass
+
+    if not trace:
+        sys.exit('Error: no trace dump found')
+
+    if args.output == '-':
+        json.dump({'traceEvents': trace}, sys.stdout)
+        print()
+    else:
+        with open(args.output, 'w') as out:
+            json.dump({'traceEvents': trace}, out)
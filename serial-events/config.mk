@@ -0,0 +1,8 @@
+# micros() from the TC4/TC5 hardware clock, and sleep in delay() between loop iterations
+CPPFLAGS += -DMICROS_USE_HWCLOCK -DDELAY_SLEEP -DDELAY_SLEEP_SUPPRESS_SYSTICK
+
+# record task run times in the trace buffer, dumped with the D command
+CPPFLAGS += -DTRACE_ENABLE
+
+# time the interrupt handlers, printed with the Q command
+CPPFLAGS += -DIRQ_STATS
@@ -1,10 +1,22 @@
-#include <ctype.h>
-
 #include "Arduino.h"
+#include "Command.h"
+#include "InputEvents.h"
+#include "IrqStats.h"
+#include "LineReader.h"
+#include "Scheduler.h"
+#include "Trace.h"
 #include "wiring_digital.h"
 
+// trace event IDs
+enum {
+    TRACE_SETUP = 1,
+    TRACE_COMMAND,
+    TRACE_INPUT,
+};
+
 #define DEBUG_PORT 0
 #define DEBUG_PIN  17
+#define DEBUG_TRACE_ID TRACE_SETUP
 #include "debug_macros.h"
 
 extern void leds_init(void);
@@ -13,86 +25,184 @@ extern void leds_set_state(int state);
 
 static constexpr unsigned long LOOP_DELAY_MS = 10;
 
-static struct {
-    int pin;
-    int last = 0;
-} inputs[] = {
-    { .pin = 9 },
-    { .pin = 8 },
+// debounced buttons, reported as input 0 and 1
+static InputButton inputs[] = {
+    InputButton(0, 9),
+    InputButton(1, 8),
 };
-static constexpr int N_INPUTS = sizeof(inputs) / sizeof(inputs[0]);
 
-void setup(void)
+// input_task flag, signalled from the input event notify callback
+static constexpr uint32_t INPUT_FLAG = 1;
+
+static char cmdbuf[32];
+static LineReader cmd_reader(cmdbuf);
+
+static bool cmd_brightness(CommandArgs &args)
 {
-    DBGINIT();
-    DBGHIGH();
+    int32_t arg;
+    if (!args.next_int(&arg))
+        return false;
 
-    for (int i = 0; i < N_INPUTS; i++)
-        pinMode(inputs[i].pin, INPUT_PULLUP);
+    const uint8_t b = static_cast<uint8_t>(arg);
+    leds_set_brightness(b);
+    SerialUSB.printf("MSG set brightness %u\r\n"_fmt, b);
+    return true;
+}
 
-    leds_init();
+static bool cmd_led_state(CommandArgs &args)
+{
+    int32_t arg;
+    if (!args.next_int(&arg))
+        return false;
 
-    //while (!SerialUSB);
-    //SerialUSB.print("Serial Events Test\r\n");
-    DBGLOW();
+    leds_set_state(arg);
+    SerialUSB.printf("MSG set LED state %d\r\n"_fmt, arg);
+    return true;
 }
 
-static void handle_cmd(const char *cmd)
+// report the fraction of time spent asleep in delay() since the last I command
+static bool cmd_idle(CommandArgs &args)
 {
-    int arg = -1;
-    if (sscanf(cmd, "L %d", &arg) == 1)
-    {
-        leds_set_state(arg);
-        SerialUSB.printf("MSG set LED state %d\r\n", arg);
-    }
-    else if (sscanf(cmd, "B %d", &arg) == 1)
-    {
-        const uint8_t b = static_cast<uint8_t>(arg);
-        leds_set_brightness(b);
-        SerialUSB.printf("MSG set brightness %u\r\n", b);
-    }
-    else
-    {
-        SerialUSB.printf("MSG Unknown Command '%s'\r\n", cmd);
-    }
+    static uint32_t last_us, last_idle_us;
+    if (!args.done())
+        return false;
+
+    const uint32_t now = micros();
+    const uint32_t idle = idleMicros();
+    const uint32_t total = now - last_us;
+    const uint32_t slept = idle - last_idle_us;
+    last_us = now;
+    last_idle_us = idle;
+
+    SerialUSB.printf("MSG idle %u%% of %u ms\r\n"_fmt,
+                     (unsigned)(total ? (uint64_t)slept * 100 / total : 0),
+                     (unsigned)(total / 1000));
+    return true;
 }
 
-void loop(void)
+static bool cmd_task_stats(CommandArgs &args)
+{
+    if (!args.done())
+        return false;
+    scheduler_print_stats(SerialUSB);
+    return true;
+}
+
+// print and reset interrupt handler run times
+static bool cmd_irq_stats(CommandArgs &args)
+{
+    if (!args.done())
+        return false;
+    irqStatsPrint(SerialUSB);
+    irqStatsReset();
+    return true;
+}
+
+// dump and clear the trace buffer, see scripts/trace2chrome.py
+static bool cmd_trace_dump(CommandArgs &args)
+{
+    if (!args.done())
+        return false;
+    trace_dump(SerialUSB);
+    return true;
+}
+
+// command names are case-insensitive, and this table must stay sorted. As
+// with the old sscanf parser, B and L also take the number directly after
+// the letter: L5
+static constexpr Command commands[] = {
+    { "B", cmd_brightness, CMD_ATTACHED_NUMBER },
+    { "D", cmd_trace_dump, 0 },
+    { "I", cmd_idle, 0 },
+    { "L", cmd_led_state, CMD_ATTACHED_NUMBER },
+    { "Q", cmd_irq_stats, 0 },
+    { "T", cmd_task_stats, 0 },
+};
+static_assert(command_table_sorted(commands), "commands table is not sorted");
+static const CommandTable command_table(commands);
+
+static void handle_cmd(const char *cmd)
 {
-    static constexpr size_t CMD_SIZE = 32;
-    static char cmd[CMD_SIZE] = {0};
-    static size_t cmd_pos = 0;
+    if (command_table.dispatch(cmd) != CMD_OK)
+        SerialUSB.printf("MSG Unknown Command '%s'\r\n"_fmt, cmd);
+}
 
-    // check for and handle commands
-    while (SerialUSB.available())
+// check for and handle commands
+static TaskState command_task(Task &t)
+{
+    TASK_BEGIN(t);
+    while (true)
     {
-        char c = static_cast<char>(SerialUSB.read());
-        if ((cmd_pos == 0) && isspace(c))
-            continue; // ignore leading space in command
-        else if (c == '\r')
-            cmd[cmd_pos++] = '\0';
-        else
-            cmd[cmd_pos++] = toupper(c);
-
-        if (c == '\r' || cmd_pos == CMD_SIZE)
-        {
-            // we have a complete command
-            cmd[CMD_SIZE-1] = '\0'; // null-terminate in case we hit the limit
-            handle_cmd(cmd);
-            cmd_pos = 0;
-        }
+        TRACE_BEGIN(TRACE_COMMAND);
+        while (cmd_reader.poll(SerialUSB))
+            handle_cmd(cmdbuf);
+        TRACE_END(TRACE_COMMAND);
+        TASK_SLEEP_MS(t, LOOP_DELAY_MS);
     }
+    TASK_END(t);
+}
 
-    // handle input events
-    for (int i = 0; i < N_INPUTS; i++)
+// Report input events as "INPUT <id> <state>", as the old polling loop did
+// with state 1 while the button pulls the pin low, followed by
+// "INPUTLAT <id> <latency us>" from the first input edge to printing,
+// including the debounce
+static TaskState input_task(Task &t)
+{
+    TASK_BEGIN(t);
+    while (true)
     {
-        const int current = !digitalRead(inputs[i].pin);
-        if (current != inputs[i].last)
+        TASK_WAIT_FLAGS(t, INPUT_FLAG);
+        t.take(INPUT_FLAG);
+
+        TRACE_BEGIN(TRACE_INPUT);
+        InputEvent ev;
+        while (input_event_pop(&ev))
         {
-            SerialUSB.printf("INPUT %d %d\r\n", i, current);
-            inputs[i].last = current;
+            SerialUSB.printf("INPUT %u %u\r\n"_fmt, ev.id, ev.type == INPUT_PRESS);
+            SerialUSB.printf("INPUTLAT %u %u\r\n"_fmt, ev.id, (unsigned)input_event_age_us(ev));
         }
+        TRACE_END(TRACE_INPUT);
     }
+    TASK_END(t);
+}
+
+static Task tasks[] = {
+    Task(command_task, "command"),
+    Task(input_task, "input"),
+};
 
-    delay(LOOP_DELAY_MS);
+// called from the interrupt that pushed an input event
+static void input_notify(void *ctx)
+{
+    static_cast<Task*>(ctx)->signal(INPUT_FLAG);
+}
+
+void setup(void)
+{
+    TRACE_NAME(TRACE_SETUP, "setup");
+    TRACE_NAME(TRACE_COMMAND, "command");
+    TRACE_NAME(TRACE_INPUT, "input");
+
+    DBGINIT();
+    DBGHIGH();
+
+    timer_service_init();
+    input_events_notify(input_notify, &tasks[1]);
+    for (InputButton &input : inputs)
+        input.begin();
+
+    leds_init();
+
+    for (Task &task : tasks)
+        scheduler_add(task);
+
+    //while (!SerialUSB);
+    //SerialUSB.print("Serial Events Test\r\n");
+    DBGLOW();
+}
+
+void loop(void)
+{
+    // tasks run from yield() while delay() waits
+    delay(1000);
 }
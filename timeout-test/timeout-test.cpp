@@ -19,6 +19,8 @@
 
 #include "Arduino.h"
 #include "DigitalIO.h"
+#include "EventRoute.h"
+#include "LineReader.h"
 #include "Timeout.h"
 
 #include <stdlib.h> // for strtoul()
@@ -27,18 +29,21 @@
 #define DEBUG_PIN  17
 #include "debug_macros.h"
 
+// The button starts the timeout through EVSYS with no interrupt: the EIC
+// event output is high while the pin is low, and its rising edge retriggers
+// TC5. The debug pin pulses when the timeout expires, so the delay from the
+// button edge to the pulse is the timeout plus the hardware latency only.
+#define BUTTON_PIN 9
+
 DigitalOut status_led(13);
-DigitalIn button(9);
 
-static void timeout_isr(void)
-{
-    DBGLOW();
-}
+static char cmdbuf[16];
+static LineReader cmd_reader(cmdbuf, true);
 
-static void button_isr(void)
+static void timeout_isr(void)
 {
     DBGHIGH();
-    timeout_start();
+    DBGLOW();
 }
 
 void setup(void)
@@ -48,26 +53,33 @@ void setup(void)
     pinMode(10, OUTPUT);
     digitalWrite(10, 0);
     timeout_init();
+    timeout_set_us<1000>();
     timeout_set_callback(&timeout_isr);
 
-    button.mode(INPUT);
-    button.add_interrupt(button_isr, FALLING);
+    pinMode(BUTTON_PIN, INPUT);
+    int extint = attachInterruptEvent(BUTTON_PIN, LOW);
+    if (extint < 0 ||
+            event_route_connect(event_gen_extint(extint), EVSYS_ID_USER_TC5_EVU,
+                                EVENT_PATH_RESYNC, EVENT_EDGE_RISING) < 0)
+        while (1);  // leave the LED on
+    timeout_set_event_start(true);
     status_led = 0;
 
     SerialUSB.begin(115200);
     while (!SerialUSB); // wait for USB host to open the port
     SerialUSB.print("SAMD21 TC Timer Test\r\n");
-    button_isr();
+    timeout_start();
+    SerialUSB.write("> ");
 }
 
 void loop(void)
 {
-    SerialUSB.write("> ");
-    char cmdbuf[16];
-    size_t cmdlen = SerialUSB.readLine(cmdbuf, sizeof(cmdbuf), true);
-    if (cmdlen)
+    if (!cmd_reader.poll(SerialUSB))
+        return;
+
+    if (cmd_reader.length())
     {
-        //SerialUSB.printf("count=%u buf='%s'\r\n", cmdlen, cmdbuf);
+        //SerialUSB.printf("count=%u buf='%s'\r\n", cmd_reader.length(), cmdbuf);
         uint32_t val = strtoul(cmdbuf, NULL, 0);
         if (val)
         {
@@ -76,7 +88,8 @@ void loop(void)
             uint32_t prescaler = TC5->COUNT16.CTRLA.bit.PRESCALER;
             SerialUSB.printf("%luus, prescaler=%lu, count=%u\r\n",
                              val, prescaler, cc);
-            button_isr();
+            timeout_start();
         }
     }
+    SerialUSB.write("> ");
 }